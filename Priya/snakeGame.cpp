@@ -1,126 +1,240 @@
+// Emoji snake on a wraparound board: leaving one edge brings the snake in
+// on the opposite side. Runs on the engine's TorusBoard and the terminal
+// layer's input, scheduler and single-write frames, so after startup it
+// spawns no processes and a tick does no allocation and no scan of the
+// board.
 #include <iostream>
 #include <vector>
-#include <cstdlib>
+#include <csignal>
+#include <cstdint>
 #include <ctime>
-#include <unistd.h>
-#include <termios.h>
-#include <sys/ioctl.h>
+
+#include "../snake_engine.h"
+#include "../snake_terminal.h"
 
 using namespace std;
 
-// Emojis
-string HEAD = "🦎";
-string BODY = "🟢";
-vector<string> FRUITS = {"🍎","🍌","🍉","🍇","🍓","🍒","🍑","🍊","🍍","🍐","🍈","🍋"};
-string EMPTY = "⬜";
+// Emojis, as code points; the renderer encodes them once at startup
+const uint32_t HEAD = 0x1F98E;    // 🦎
+const uint32_t BODY = 0x1F7E2;    // 🟢
+const uint32_t FRUITS[] = { 0x1F34E, 0x1F34C, 0x1F349, 0x1F347, 0x1F353, 0x1F352,
+                            0x1F351, 0x1F34A, 0x1F34D, 0x1F350, 0x1F348, 0x1F34B };
+const int FRUIT_COUNT = sizeof(FRUITS) / sizeof(FRUITS[0]);
+const uint32_t EMPTY = 0x2B1C;    // ⬜
 
 // Board size
 const int ROWS = 10;
 const int COLS = 10;
 
-// Snake state
-vector<pair<int, int>> snake = {{5, 5}};
-pair<int, int> food;
-string fruit;
-string direction = "RIGHT";
-
-bool kbhit() {
-    termios term;
-    tcgetattr(0, &term);
+// Every cell is this many terminal columns wide
+const int CELL_WIDTH = 2;
 
-    termios term2 = term;
-    term2.c_lflag &= ~ICANON;
-    tcsetattr(0, TCSANOW, &term2);
+const int TICK_MS = 200;
 
-    int bytesWaiting;
-    ioctl(0, FIONREAD, &bytesWaiting);
+static volatile sig_atomic_t quitRequested = 0;
 
-    tcsetattr(0, TCSANOW, &term);
-    return bytesWaiting > 0;
+static void onSignal(int) {
+    quitRequested = 1;
 }
 
-char getch() {
-    char buf = 0;
-    termios old = {0};
-    tcgetattr(0, &old);
-    old.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(0, TCSANOW, &old);
-    read(0, &buf, 1);
-    tcsetattr(0, TCSANOW, &old);
-    return buf;
+// Terminal columns a code point takes up. The emoji and symbol blocks
+// used here are East Asian Wide; anything else is taken as one column.
+int glyphWidth(uint32_t cp) {
+    if ((cp >= 0x1F300 && cp <= 0x1F64F) || (cp >= 0x1F680 && cp <= 0x1F6FF) ||
+        (cp >= 0x1F7E0 && cp <= 0x1F7EB) || (cp >= 0x1F90C && cp <= 0x1F9FF) ||
+        (cp >= 0x2B1B && cp <= 0x2B1C)) {
+        return 2;
+    }
+    return 1;
 }
 
-void spawnFood() {
-    food.first = rand() % ROWS;
-    food.second = rand() % COLS;
-    fruit = FRUITS[rand() % FRUITS.size()];
+// UTF-8 bytes of a code point; returns how many were written (1 to 4)
+int encodeUtf8(uint32_t cp, char* out) {
+    if (cp < 0x80) {
+        out[0] = cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = 0xC0 | (cp >> 6);
+        out[1] = 0x80 | (cp & 0x3F);
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = 0xE0 | (cp >> 12);
+        out[1] = 0x80 | ((cp >> 6) & 0x3F);
+        out[2] = 0x80 | (cp & 0x3F);
+        return 3;
+    }
+    out[0] = 0xF0 | (cp >> 18);
+    out[1] = 0x80 | ((cp >> 12) & 0x3F);
+    out[2] = 0x80 | ((cp >> 6) & 0x3F);
+    out[3] = 0x80 | (cp & 0x3F);
+    return 4;
 }
 
-void printBoard() {
-    system("clear");
-    for (int r = 0; r < ROWS; ++r) {
-        for (int c = 0; c < COLS; ++c) {
-            bool printed = false;
-
-            if (r == snake[0].first && c == snake[0].second) {
-                cout << HEAD;
-                printed = true;
-            } else {
-                for (size_t i = 1; i < snake.size(); ++i) {
-                    if (r == snake[i].first && c == snake[i].second) {
-                        cout << BODY;
-                        printed = true;
-                        break;
-                    }
-                }
-            }
+// Draws a TorusBoard with one emoji per cell. Glyphs are encoded once and
+// padded to CELL_WIDTH columns, so cell (r, c) always starts at screen
+// column c * CELL_WIDTH. A frame writes only the cells the board reported
+// as changed, and goes out in one write; the composer skips the cursor
+// move when the previous cell left the cursor in place. The board only
+// knows there is food, so the renderer picks a fruit each time it moves.
+class EmojiRenderer {
+private:
+    // A pre-encoded cell: UTF-8 bytes plus padding, NUL-terminated
+    struct Glyph {
+        char bytes[4 + CELL_WIDTH + 1];
+    };
+
+    FrameComposer composer;
+    Glyph empty;
+    Glyph head;
+    Glyph body;
+    Glyph fruits[FRUIT_COUNT];
+    int fruit;                 // index into FRUITS
+    Position fruitPos;         // where that fruit was drawn
+    Rng fruitRng;
+    int shownLength;
+
+    static Glyph encode(uint32_t cp) {
+        Glyph glyph;
+        int n = encodeUtf8(cp, glyph.bytes);
+        for (int w = glyphWidth(cp); w < CELL_WIDTH; w++) {
+            glyph.bytes[n++] = ' ';
+        }
+        glyph.bytes[n] = '\0';
+        return glyph;
+    }
+
+    const Glyph& glyphFor(CellKind kind) const {
+        switch (kind) {
+            case CELL_HEAD: return head;
+            case CELL_BODY: return body;
+            case CELL_FOOD: return fruits[fruit];
+            default:        return empty;
+        }
+    }
+
+    void putCell(Position pos, CellKind kind) {
+        if (kind == CELL_FOOD && !(pos == fruitPos)) {
+            fruit = fruitRng.nextBelow(FRUIT_COUNT);
+            fruitPos = pos;
+        }
+        composer.moveTo(pos.col * CELL_WIDTH, pos.row);
+        composer.glyph(glyphFor(kind).bytes, CELL_WIDTH);
+    }
+
+    void putLength(const TorusBoard& board) {
+        composer.moveTo(0, board.getRows() + 2);
+        composer.text("Length: ");
+        composer.appendNumber(board.getSnakeLength());
+        composer.text("   ");
+        shownLength = board.getSnakeLength();
+    }
 
-            if (!printed) {
-                if (r == food.first && c == food.second) cout << fruit;
-                else cout << EMPTY;
+public:
+    explicit EmojiRenderer(uint64_t seed)
+        : composer(true), empty(encode(EMPTY)), head(encode(HEAD)), body(encode(BODY)),
+          fruit(0), fruitPos(-1, -1), fruitRng(seed), shownLength(0) {
+        for (int i = 0; i < FRUIT_COUNT; i++) {
+            fruits[i] = encode(FRUITS[i]);
+        }
+    }
+
+    void renderInitial(TorusBoard& board) {
+        // Clear the screen and hide the cursor as part of the same write
+        composer.begin();
+        composer.text("\033[?25l");
+        composer.clearScreen();
+        for (int r = 0; r < board.getRows(); r++) {
+            for (int c = 0; c < board.getCols(); c++) {
+                putCell(Position(r, c), board.cellAt(Position(r, c)));
             }
         }
-        cout << endl;
+        composer.moveTo(0, board.getRows() + 1);
+        composer.text("Controls: W ↑ | S ↓ | A ← | D → | Q or Ctrl+C to exit");
+        putLength(board);
+        composer.flush();
+        board.getChanges().clear();
     }
-    cout << "\nControls: W ↑ | S ↓ | A ← | D → | Ctrl+C to exit\n";
-    cout << "Length: " << snake.size() << endl;
-}
 
-void moveSnake() {
-    pair<int, int> head = snake[0];
-    if (direction == "UP") head.first = (head.first - 1 + ROWS) % ROWS;
-    else if (direction == "DOWN") head.first = (head.first + 1) % ROWS;
-    else if (direction == "LEFT") head.second = (head.second - 1 + COLS) % COLS;
-    else if (direction == "RIGHT") head.second = (head.second + 1) % COLS;
-
-    // Check if food is eaten
-    if (head == food) {
-        snake.insert(snake.begin(), head); // Grow
-        spawnFood();
-    } else {
-        snake.insert(snake.begin(), head);
-        snake.pop_back();
+    void render(TorusBoard& board) {
+        CellChangeList& changes = board.getChanges();
+        if (changes.hasOverflowed()) {
+            renderInitial(board);
+            return;
+        }
+        if (changes.size() == 0 && shownLength == board.getSnakeLength()) {
+            return;
+        }
+
+        composer.begin();
+        for (int i = 0; i < changes.size(); i++) {
+            putCell(changes[i].pos, changes[i].kind);
+        }
+        changes.clear();
+        if (shownLength != board.getSnakeLength()) {
+            putLength(board);
+        }
+        composer.flush();
     }
-}
+
+    // Leave the cursor below the board, visible again
+    void finish(const TorusBoard& board) {
+        composer.begin();
+        composer.moveTo(0, board.getRows() + 3);
+        composer.text("\033[?25h");
+        composer.flush();
+    }
+};
 
 int main() {
-    srand(time(0));
-    spawnFood();
-
-    while (true) {
-        if (kbhit()) {
-            char key = getch();
-            key = tolower(key);
-            if (key == 'w') direction = "UP";
-            else if (key == 's') direction = "DOWN";
-            else if (key == 'a') direction = "LEFT";
-            else if (key == 'd') direction = "RIGHT";
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    uint64_t seed = time(0) ^ monotonicNanos();
+    TorusBoard board(ROWS, COLS, seed);
+    InputHandler input;
+    EmojiRenderer renderer(splitmix64(seed));
+    TickScheduler scheduler(TICK_MS, TICK_MS);
+    renderer.renderInitial(board);
+
+    scheduler.start();
+    while (!quitRequested && !board.isGameOver()) {
+        input.waitUntil(scheduler.getNextDeadline());
+        int dueTicks = scheduler.collectDueTicks();
+
+        for (int i = 0; i < dueTicks && !quitRequested && !board.isGameOver(); i++) {
+            // At most one turn per tick; keys that change nothing are skipped
+            Action action = ACTION_NONE;
+            char key;
+            while ((key = input.popKey()) != KEY_NONE) {
+                Direction wanted;
+                if (key == 'W' || key == KEY_UP) wanted = UP;
+                else if (key == 'S' || key == KEY_DOWN) wanted = DOWN;
+                else if (key == 'A' || key == KEY_LEFT) wanted = LEFT;
+                else if (key == 'D' || key == KEY_RIGHT) wanted = RIGHT;
+                else {
+                    if (key == 'Q') quitRequested = 1;
+                    continue;
+                }
+                Direction current = board.getSnake()->getDirection();
+                if (wanted == current || wanted == opposite(current)) continue;
+                action = actionFor(wanted);
+                break;
+            }
+            if (quitRequested) break;
+            board.step(action);
         }
 
-        moveSnake();
-        printBoard();
-        usleep(200000); // speed (microseconds) → 200000 = 0.2s
+        if (scheduler.renderDue()) {
+            renderer.render(board);
+        }
     }
+    renderer.finish(board);
+    input.cleanup();
 
+    if (board.isGameOver()) {
+        cout << "Game over! Length: " << board.getSnakeLength() << endl;
+    }
     return 0;
 }
@@ -0,0 +1,239 @@
+#include "snake_autopilot.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+using namespace std;
+
+Autopilot::Autopilot(int r, int c)
+    : rows(r), cols(c), stamps((size_t)r * c, 0), parents((size_t)r * c, 0),
+      ring((size_t)r * c, 0), base(0), plan((size_t)r * c, 0), planLength(0), planStep(0),
+      planMode(MODE_ANY), decisions(0), totalNanos(0), maxNanos(0) {
+    fill(modeCounts, modeCounts + MODE_COUNT, 0);
+    fill(latencyBuckets, latencyBuckets + LATENCY_BUCKETS, 0);
+}
+
+void Autopilot::nextGeneration() {
+    base += 2;
+    // Stamps wrap after about two billion searches; start over from zero
+    if (base >= 0xFFFFFFF0u) {
+        fill(stamps.begin(), stamps.end(), 0);
+        base = 2;
+    }
+}
+
+bool Autopilot::isBlocked(const GameBoard& board, Position pos) const {
+    if (!isInterior(pos)) return true;
+    if (!board.isOccupied(pos)) return false;
+    // The tail moves out of the way this tick unless the snake is growing
+    return !(pos == board.getTail()) || board.getSnake()->isGrowing();
+}
+
+int Autopilot::search(const GameBoard& board, Position start, Position target, bool virtualBody) {
+    if (start == target) return 0;
+    if (!virtualBody) nextGeneration();
+
+    int total = rows * cols;
+    uint32_t visited = base + 1;
+    stamps[cellOf(start)] = visited;
+    int front = 0;
+    int back = 1;
+    int count = 1;
+    ring[0] = cellOf(start);
+
+    while (count > 0) {
+        int cell = ring[front];
+        if (++front == total) front = 0;
+        count--;
+
+        Position pos = positionOf(cell);
+        int distance = abs(pos.row - target.row) + abs(pos.col - target.col);
+        for (int d = 0; d < 4; d++) {
+            Position next = stepFrom(pos, (Direction)d);
+            // Right after eating the tail stays put for a tick, so in the
+            // safety check it cannot be the very next cell
+            if (next == target && !(virtualBody && pos == start)) {
+                parents[cellOf(next)] = d;
+                int length = 0;
+                for (Position walk = target; !(walk == start); length++) {
+                    walk = stepFrom(walk, (Direction)(parents[cellOf(walk)] ^ 1));
+                }
+                return length;
+            }
+            if (!isInterior(next)) continue;
+            int nextCell = cellOf(next);
+            uint32_t stamp = stamps[nextCell];
+            if (stamp == visited) continue;
+            if (virtualBody ? stamp == base : isBlocked(board, next)) continue;
+
+            stamps[nextCell] = visited;
+            parents[nextCell] = d;
+            // Steps toward the target keep the A* estimate and go first;
+            // steps away raise it by two and go last
+            int nextDistance = abs(next.row - target.row) + abs(next.col - target.col);
+            if (nextDistance < distance) {
+                front = (front == 0 ? total : front) - 1;
+                ring[front] = nextCell;
+            } else {
+                ring[back] = nextCell;
+                if (++back == total) back = 0;
+            }
+            count++;
+        }
+    }
+    return -1;
+}
+
+void Autopilot::storePlan(Position target, int length, int offset) {
+    Position pos = target;
+    for (int i = offset + length - 1; i >= offset; i--) {
+        plan[i] = parents[cellOf(pos)];
+        pos = stepFrom(pos, (Direction)(plan[i] ^ 1));
+    }
+    planLength = offset + length;
+    planStep = 0;
+}
+
+bool Autopilot::isSafeAfter(const GameBoard& board, Position food) {
+    // Stamp the body as it would be on eating: the path back from the
+    // food, then as much of the current body as is still attached
+    nextGeneration();
+    const Snake* snake = board.getSnake();
+    Position head = snake->getHead();
+    // A snake that has just eaten is one segment longer by the time it moves
+    int length = snake->getLength() + (snake->isGrowing() ? 1 : 0);
+    int marked = 0;
+    Position tail = food;
+
+    Position pos = food;
+    while (marked < length && !(pos == head)) {
+        stamps[cellOf(pos)] = base;
+        tail = pos;
+        marked++;
+        pos = stepFrom(pos, (Direction)(parents[cellOf(pos)] ^ 1));
+    }
+    if (marked < length) {
+        for (Position segment : snake->getBody()) {
+            if (marked == length) break;
+            stamps[cellOf(segment)] = base;
+            tail = segment;
+            marked++;
+        }
+    }
+
+    return search(board, food, tail, true) > 0;
+}
+
+Direction Autopilot::followPlan(Position head, Mode planned, Mode& mode) {
+    planMode = planned;
+    planStep = 1;
+    planHead = stepFrom(head, (Direction)plan[0]);
+    mode = planned;
+    return (Direction)plan[0];
+}
+
+Direction Autopilot::choose(const GameBoard& board, Mode& mode) {
+    const Snake* snake = board.getSnake();
+    Position head = snake->getHead();
+    Direction current = snake->getDirection();
+    Position food = board.getFoodPosition();
+
+    // 0. Carry on with the plan while the board is as it expected. Tail
+    // plans stop short of food, which was not safe to eat when they were
+    // made
+    if (planStep < planLength && head == planHead &&
+        (planMode == MODE_TAIL || food == planFood)) {
+        Direction dir = (Direction)plan[planStep];
+        Position next = stepFrom(head, dir);
+        if (!isBlocked(board, next) && (planMode == MODE_FOOD || !(next == food))) {
+            planStep++;
+            planHead = next;
+            mode = planMode;
+            return dir;
+        }
+    }
+    planLength = 0;
+
+    // 1. Shortest path to the food, if eating leaves a way to the tail
+    if (food.row >= 0) {
+        int length = search(board, head, food, false);
+        if (length > 0) {
+            storePlan(food, length, 0);
+            if (isSafeAfter(board, food)) {
+                planFood = food;
+                return followPlan(head, MODE_FOOD, mode);
+            }
+            planLength = 0;
+        }
+    }
+
+    // 2. Follow the tail, taking the move with the longest way round to it
+    // and leaving the food alone
+    Position tail = snake->getTail();
+    int bestLength = -1;
+    Direction best = current;
+    for (int d = 0; d < 4; d++) {
+        if (d == (current ^ 1)) continue;
+        Position next = stepFrom(head, (Direction)d);
+        if (isBlocked(board, next) || next == food) continue;
+        int length = search(board, next, tail, false);
+        if (length > bestLength) {
+            bestLength = length;
+            best = (Direction)d;
+        }
+    }
+    if (bestLength >= 0) {
+        // Search again for the winner's path and plan the whole way round
+        Position next = stepFrom(head, best);
+        plan[0] = best;
+        storePlan(tail, search(board, next, tail, false), 1);
+        return followPlan(head, MODE_TAIL, mode);
+    }
+
+    // 3. The Hamiltonian cycle, where the board has one
+    if (rows % 2 == 0) {
+        Direction dir = cycleDirection(head, rows, cols);
+        if (dir != (current ^ 1) && !isBlocked(board, stepFrom(head, dir))) {
+            mode = MODE_CYCLE;
+            return dir;
+        }
+    }
+
+    // 4. Anything that survives this tick
+    mode = MODE_ANY;
+    for (int d = 0; d < 4; d++) {
+        if (d != (current ^ 1) && !isBlocked(board, stepFrom(head, (Direction)d))) {
+            return (Direction)d;
+        }
+    }
+    return current;
+}
+
+Direction Autopilot::decide(const GameBoard& board) {
+    auto start = chrono::steady_clock::now();
+    Mode mode = MODE_ANY;
+    Direction dir = choose(board, mode);
+    long long nanos = chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now() - start).count();
+
+    decisions++;
+    modeCounts[mode]++;
+    totalNanos += nanos;
+    maxNanos = max(maxNanos, nanos);
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && (1LL << bucket) < nanos) bucket++;
+    latencyBuckets[bucket]++;
+    return dir;
+}
+
+double Autopilot::getPercentileMicros(double p) const {
+    if (decisions == 0) return 0;
+    long long wanted = (long long)(p / 100.0 * decisions);
+    long long seen = 0;
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += latencyBuckets[bucket];
+        if (seen > wanted) return min((double)(1LL << bucket), (double)maxNanos) / 1e3;
+    }
+    return getMaxMicros();
+}
@@ -0,0 +1,110 @@
+// Autopilot: picks a direction for the snake every tick by searching the
+// board. It takes the path to the food when, once the food is eaten, the
+// snake could still reach its own tail; otherwise it follows its tail
+// along the roomiest safe move, then falls back to the Hamiltonian cycle
+// and finally to any free neighbour. A path it commits to is kept as a
+// plan and followed on later ticks without searching again: a food path
+// is safe step by step because the check simulated exactly that path, and
+// a tail path only enters cells that were free when it was planned.
+//
+// All search state is allocated once, sized to the board: a generation
+// stamp per cell (so nothing is cleared between searches), the direction
+// each cell was entered from, a ring used as the search deque and the
+// plan. About 10 bytes per cell; nothing is allocated per decision.
+#ifndef SNAKE_AUTOPILOT_H
+#define SNAKE_AUTOPILOT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "snake_engine.h"
+
+class Autopilot {
+public:
+    // Which rule produced a decision
+    enum Mode {
+        MODE_FOOD,
+        MODE_TAIL,
+        MODE_CYCLE,
+        MODE_ANY,
+        MODE_COUNT
+    };
+
+private:
+    static const int LATENCY_BUCKETS = 40;  // powers of two of nanoseconds
+
+    int rows;
+    int cols;
+    std::vector<uint32_t> stamps;   // == base: blocked (safety check), == base + 1: visited
+    std::vector<uint8_t> parents;   // direction the search entered each cell with
+    std::vector<int32_t> ring;      // search deque, one slot per cell
+    uint32_t base;
+
+    std::vector<uint8_t> plan;      // directions still to take
+    int planLength;
+    int planStep;
+    Position planHead;              // where the head should be when planStep is taken
+    Position planFood;              // food a food plan leads to
+    Mode planMode;
+
+    long long decisions;
+    long long modeCounts[MODE_COUNT];
+    long long totalNanos;
+    long long maxNanos;
+    long long latencyBuckets[LATENCY_BUCKETS];
+
+    int cellOf(Position pos) const { return pos.row * cols + pos.col; }
+    Position positionOf(int cell) const { return Position(cell / cols, cell % cols); }
+
+    bool isInterior(Position pos) const {
+        return pos.row > 0 && pos.row < rows - 1 && pos.col > 0 && pos.col < cols - 1;
+    }
+
+    // Begin a new search generation
+    void nextGeneration();
+
+    // Search from start to target, expanding cells nearer the target first
+    // (A* ordering with a deque, since each step changes the Manhattan
+    // estimate by exactly one). With virtualBody, blocked cells are those
+    // stamped with base by the caller; otherwise they are the snake's,
+    // minus its tail when it is about to move. Returns the path length or
+    // -1; parents then lead back from target to start.
+    int search(const GameBoard& board, Position start, Position target, bool virtualBody);
+
+    // After a food search: would the snake, having followed that path and
+    // eaten, still be able to reach its own tail?
+    bool isSafeAfter(const GameBoard& board, Position food);
+
+    // Copy the path the last search found, ending at target, into the plan
+    // after offset steps
+    void storePlan(Position target, int length, int offset);
+
+    // Start on a freshly stored plan and return its first step
+    Direction followPlan(Position head, Mode planned, Mode& mode);
+
+    bool isBlocked(const GameBoard& board, Position pos) const;
+    Direction choose(const GameBoard& board, Mode& mode);
+
+public:
+    Autopilot(int r, int c);
+
+    // Forget the current plan; call when a new game starts
+    void reset() { planLength = 0; }
+
+    // Direction to take this tick
+    Direction decide(const GameBoard& board);
+
+    Action nextAction(const GameBoard& board) {
+        return actionFor(decide(board));
+    }
+
+    long long getDecisions() const { return decisions; }
+    long long getModeCount(Mode mode) const { return modeCounts[mode]; }
+    double getMeanMicros() const { return decisions ? totalNanos / 1e3 / decisions : 0; }
+    double getMaxMicros() const { return maxNanos / 1e3; }
+
+    // Upper bound of the latency bucket holding the given percentile
+    double getPercentileMicros(double p) const;
+};
+
+#endif
@@ -0,0 +1,349 @@
+// Batch simulator for bot evaluation: plays N independent games across a
+// work-stealing pool with no sleeping and summarizes the outcomes. Every
+// game is seeded from the master seed and its index, so results do not
+// depend on thread count or scheduling.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "snake_bitboard.h"
+#include "snake_engine.h"
+#include "snake_scores.h"
+#include "work_pool.h"
+
+using namespace std;
+
+enum Outcome {
+    OUTCOME_DIED = 0,
+    OUTCOME_STEP_LIMIT = 1
+};
+
+// One finished game; also the record layout of the binary summary
+struct GameResult {
+    uint64_t seed;
+    int32_t score;
+    int32_t length;
+    int32_t steps;
+    int32_t outcome;
+};
+
+// Step toward the food, never into a wall or body cell if another move
+// exists; ties are broken with the game's own policy RNG. Board is
+// GameBoard or a BitboardBoard.
+template <typename Board>
+Action greedyAction(const Board& board, Rng& rng) {
+    static const Direction directions[4] = { UP, DOWN, LEFT, RIGHT };
+    static const int rowDelta[4] = { -1, 1, 0, 0 };
+    static const int colDelta[4] = { 0, 0, -1, 1 };
+
+    Position head = board.getHead();
+    Position food = board.getFoodPosition();
+    Position tail = board.getTail();
+
+    Action best[4];
+    int bestCount = 0;
+    int bestDistance = 1 << 30;
+    for (int i = 0; i < 4; i++) {
+        Position next(head.row + rowDelta[i], head.col + colDelta[i]);
+        if (next.row <= 0 || next.row >= board.getRows() - 1 ||
+            next.col <= 0 || next.col >= board.getCols() - 1) {
+            continue;
+        }
+        if (board.isOccupied(next) && !(next == tail)) {
+            continue;
+        }
+
+        int distance = abs(next.row - food.row) + abs(next.col - food.col);
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            bestCount = 0;
+        }
+        if (distance == bestDistance) {
+            best[bestCount++] = (Action)(ACTION_UP + (directions[i] - UP));
+        }
+    }
+
+    if (bestCount == 0) return ACTION_NONE;
+    return best[rng.nextBelow(bestCount)];
+}
+
+Action randomAction(Rng& rng) {
+    uint32_t roll = rng.nextBelow(16);
+    return roll < 4 ? (Action)(ACTION_UP + roll) : ACTION_NONE;
+}
+
+template <typename Board>
+GameResult playGame(int rows, int cols, uint64_t masterSeed, long long index,
+                    bool greedy, int stepLimit) {
+    GameResult result;
+    result.seed = splitmix64(masterSeed + index);
+
+    Board board(rows, cols, result.seed);
+    Rng policyRng(result.seed ^ 0xD1B54A32D192ED03ULL);
+
+    int steps = 0;
+    while (!board.isGameOver() && steps < stepLimit) {
+        Action action = greedy ? greedyAction(board, policyRng) : randomAction(policyRng);
+        board.step(action);
+        steps++;
+    }
+
+    result.score = board.getScore();
+    result.length = board.getSnakeLength();
+    result.steps = steps;
+    result.outcome = board.isGameOver() ? OUTCOME_DIED : OUTCOME_STEP_LIMIT;
+    return result;
+}
+
+typedef GameResult (*PlayFunction)(int, int, uint64_t, long long, bool, int);
+
+void writeCsvRows(FILE* csv, const vector<GameResult>& results, long long from, long long to) {
+    for (long long i = from; i < to; i++) {
+        const GameResult& r = results[i];
+        fprintf(csv, "%lld,%llu,%d,%d,%d,%s\n", i, (unsigned long long)r.seed, r.score,
+                r.length, r.steps, r.outcome == OUTCOME_DIED ? "died" : "step_limit");
+    }
+}
+
+void recordScores(ScoreStore& store, const char* name, const vector<GameResult>& results,
+                  long long from, long long to) {
+    for (long long i = from; i < to; i++) {
+        const GameResult& r = results[i];
+        store.record(name, r.score, r.length, r.steps);
+    }
+}
+
+double percentile(const vector<int>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+void printUsage() {
+    cout << "Usage: snake_batch [options]" << endl;
+    cout << "  --games N       games to play (default 100000)" << endl;
+    cout << "  --rows N        board rows, 4 to 32766 (default 20)" << endl;
+    cout << "  --cols N        board columns, 6 to 32766 (default 40)" << endl;
+    cout << "  --seed N        master seed (default 1)" << endl;
+    cout << "  --threads N     worker threads (default: all cores)" << endl;
+    cout << "  --policy NAME   greedy | random (default greedy)" << endl;
+    cout << "  --step-limit N  stop a game after N steps (default 100 per cell)" << endl;
+    cout << "  --engine NAME   auto | generic (auto uses a bitboard engine for" << endl;
+    cout << "                  10x10, 20x20, 20x40, 22x40, 32x32 and 64x64)" << endl;
+    cout << "  --csv FILE      stream one row per game to FILE" << endl;
+    cout << "  --bin FILE      write GameResult records to FILE" << endl;
+    cout << "  --scores FILE   append every game to the score store at FILE" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    long long games = 100000;
+    int rows = 20;
+    int cols = 40;
+    uint64_t masterSeed = 1;
+    int threadCount = 0;
+    bool greedy = true;
+    int stepLimit = 0;
+    const char* csvPath = NULL;
+    const char* binPath = NULL;
+    const char* scoresPath = NULL;
+    bool generic = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--games" && hasValue) {
+            games = atoll(argv[++i]);
+        } else if (arg == "--rows" && hasValue) {
+            rows = atoi(argv[++i]);
+        } else if (arg == "--cols" && hasValue) {
+            cols = atoi(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            masterSeed = strtoull(argv[++i], NULL, 10);
+        } else if (arg == "--threads" && hasValue) {
+            threadCount = atoi(argv[++i]);
+        } else if (arg == "--policy" && hasValue) {
+            string name = argv[++i];
+            if (name != "greedy" && name != "random") {
+                printUsage();
+                return 1;
+            }
+            greedy = name == "greedy";
+        } else if (arg == "--step-limit" && hasValue) {
+            stepLimit = atoi(argv[++i]);
+        } else if (arg == "--csv" && hasValue) {
+            csvPath = argv[++i];
+        } else if (arg == "--bin" && hasValue) {
+            binPath = argv[++i];
+        } else if (arg == "--scores" && hasValue) {
+            scoresPath = argv[++i];
+        } else if (arg == "--engine" && hasValue) {
+            string name = argv[++i];
+            if (name != "auto" && name != "generic") {
+                printUsage();
+                return 1;
+            }
+            generic = name == "generic";
+        } else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (rows < MIN_BOARD_ROWS || cols < MIN_BOARD_COLS || rows > 32766 || cols > 32766 ||
+        games <= 0) {
+        printUsage();
+        return 1;
+    }
+
+    // Steps are counted in an int32 (GameResult::steps), so the default is
+    // clamped on boards of over 21 million cells
+    if (stepLimit <= 0) stepLimit = (int)min(100LL * rows * cols, (long long)INT32_MAX);
+
+    // Both engines play identical games; the bitboard one is just faster
+    PlayFunction play = &playGame<GameBoard>;
+    const char* engine = GameBoard::engineName();
+    if (!generic) {
+        dispatchBoard(rows, cols, [&](auto* type) {
+            typedef remove_pointer_t<decltype(type)> Board;
+            play = &playGame<Board>;
+            engine = Board::engineName();
+        });
+    }
+
+    FILE* csv = NULL;
+    if (csvPath) {
+        csv = fopen(csvPath, "w");
+        if (!csv) {
+            cerr << "Could not open " << csvPath << endl;
+            return 1;
+        }
+        fprintf(csv, "game,seed,score,length,steps,outcome\n");
+    }
+
+    ScoreStore store;
+    if (scoresPath && !store.open(scoresPath)) {
+        cerr << store.getError() << endl;
+        return 1;
+    }
+    if (store.getRecoveredBytes() > 0 || store.getSkippedRecords() > 0) {
+        cerr << scoresPath << ": cut off a " << store.getRecoveredBytes()
+             << "-byte torn tail, skipped " << store.getSkippedRecords() << " damaged records" << endl;
+    }
+    const char* player = greedy ? "greedy" : "random";
+    double recordSeconds = 0;
+
+    vector<GameResult> results(games);
+    vector<atomic<bool>> finished(games);
+    for (long long i = 0; i < games; i++) finished[i] = false;
+
+    // Small chunks keep stealing effective when game lengths vary
+    const long long chunk = 64;
+    WorkStealingPool pool(threadCount);
+    auto start = chrono::steady_clock::now();
+
+    for (long long first = 0; first < games; first += chunk) {
+        long long last = min(games, first + chunk);
+        pool.submit([&, first, last] {
+            for (long long i = first; i < last; i++) {
+                results[i] = play(rows, cols, masterSeed, i, greedy, stepLimit);
+                finished[i].store(true, memory_order_release);
+            }
+        });
+    }
+
+    // Stream the finished prefix in game order while the pool works
+    long long written = 0;
+    while (written < games) {
+        long long ready = written;
+        while (ready < games && finished[ready].load(memory_order_acquire)) ready++;
+        if (csv && ready > written) writeCsvRows(csv, results, written, ready);
+        if (scoresPath && ready > written) {
+            auto recordStart = chrono::steady_clock::now();
+            recordScores(store, player, results, written, ready);
+            recordSeconds += chrono::duration<double>(chrono::steady_clock::now() - recordStart).count();
+        }
+        if (ready == written) this_thread::sleep_for(chrono::milliseconds(20));
+        written = ready;
+    }
+    pool.wait();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (csv) fclose(csv);
+
+    if (binPath) {
+        FILE* bin = fopen(binPath, "wb");
+        if (!bin) {
+            cerr << "Could not open " << binPath << endl;
+            return 1;
+        }
+        fwrite(results.data(), sizeof(GameResult), results.size(), bin);
+        fclose(bin);
+    }
+
+    // Aggregate summary
+    long long totalSteps = 0;
+    long long stepLimited = 0;
+    double lengthSum = 0;
+    vector<int> scores;
+    scores.reserve(games);
+    for (const GameResult& r : results) {
+        totalSteps += r.steps;
+        lengthSum += r.length;
+        if (r.outcome == OUTCOME_STEP_LIMIT) stepLimited++;
+        scores.push_back(r.score);
+    }
+    sort(scores.begin(), scores.end());
+    double scoreSum = 0;
+    for (int score : scores) scoreSum += score;
+
+    printf("Games:          %lld on %dx%d (%s policy)\n", games, rows, cols, greedy ? "greedy" : "random");
+    printf("Engine:         %s\n", engine);
+    printf("Threads:        %d\n", pool.size());
+    printf("Total steps:    %lld\n", totalSteps);
+    printf("Time:           %.3f s\n", seconds);
+    printf("Steps/sec:      %.0f\n", totalSteps / seconds);
+    printf("Score:          mean %.1f  p50 %.0f  p90 %.0f  p99 %.0f  max %d\n",
+           scoreSum / games, percentile(scores, 0.5), percentile(scores, 0.9),
+           percentile(scores, 0.99), scores.back());
+    printf("Length:         mean %.1f\n", lengthSum / games);
+    printf("Steps to end:   mean %.1f  (%lld hit the step limit)\n",
+           (double)totalSteps / games, stepLimited);
+
+    // Score distribution in ten equal-width buckets
+    int maxScore = scores.back();
+    int width = maxScore / 10 + 10;
+    width -= width % 10;
+    printf("Score distribution:\n");
+    for (int bucket = 0; bucket * width <= maxScore; bucket++) {
+        long long low = lower_bound(scores.begin(), scores.end(), bucket * width) - scores.begin();
+        long long high = lower_bound(scores.begin(), scores.end(), (bucket + 1) * width) - scores.begin();
+        printf("  %6d-%-6d %lld\n", bucket * width, (bucket + 1) * width - 10, high - low);
+    }
+
+    if (scoresPath) {
+        // Closing syncs and writes the index; reopening shows what the
+        // next game-over screen will pay to load the leaderboard
+        long long compactions = store.getCompactions();
+        store.close();
+        compactions = max(compactions, store.getCompactions());
+        auto openStart = chrono::steady_clock::now();
+        if (!store.open(scoresPath)) {
+            cerr << store.getError() << endl;
+            return 1;
+        }
+        double openMs = chrono::duration<double, milli>(chrono::steady_clock::now() - openStart).count();
+        printf("Scores:         %lld games recorded in %.3f s, %lld compactions\n",
+               games, recordSeconds, compactions);
+        printf("Score store:    %llu games, %.1f KiB log, reopened in %.2f ms, best %d\n",
+               (unsigned long long)store.getGames(), store.getLogBytes() / 1024.0, openMs,
+               store.getBest());
+    }
+    return 0;
+}
@@ -0,0 +1,500 @@
+// Benchmarks for the engine and renderer hot paths. Every case runs at
+// each requested board size and snake length, with the snake laid along
+// the Hamiltonian cycle so it can move forever without dying. Results go
+// out as JSON (ns per op, heap allocations per op, bytes per frame) so
+// runs from different commits can be diffed.
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include "snake_engine.h"
+#include "snake_autopilot.h"
+#include "snake_planner.h"
+#include "snake_replay.h"
+#include "snake_terminal.h"
+
+using namespace std;
+
+// Every heap allocation in the process goes through here, from any thread
+static atomic<long long> allocationCount(0);
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+// Keeps results of pure calls alive so the loops are not optimized away;
+// the calls themselves go through volatile pointers so they are not
+// hoisted out of the loop
+static volatile long long sink = 0;
+
+struct BenchResult {
+    string name;
+    int rows;
+    int cols;
+    int length;
+    long long iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;    // output bytes, render cases only
+    double p50Ns;         // per-tick percentiles, full loop only
+    double p99Ns;
+    double maxNs;
+};
+
+// Run body(n) with a doubling n until one batch takes at least minSeconds;
+// the last batch is the one reported
+static BenchResult measure(const string& name, double minSeconds,
+                           const function<void(long long)>& body) {
+    BenchResult result = BenchResult();
+    result.name = name;
+    long long n = 1;
+    while (true) {
+        long long allocsBefore = allocationCount;
+        auto start = chrono::steady_clock::now();
+        body(n);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (seconds >= minSeconds || n >= (1LL << 40)) {
+            result.iterations = n;
+            result.nsPerOp = seconds * 1e9 / n;
+            result.allocsPerOp = (double)(allocationCount - allocsBefore) / n;
+            return result;
+        }
+        n *= 2;
+    }
+}
+
+// Lay a snake of the given length along the cycle, head last in walking
+// order, and continue along the cycle from there
+static void placeOnCycle(GameBoard& board, int length) {
+    int rows = board.getRows();
+    int cols = board.getCols();
+    vector<Position> path;
+    path.reserve(length);
+    Position pos(1, 1);
+    for (int i = 0; i < length; i++) {
+        path.push_back(pos);
+        switch (cycleDirection(pos, rows, cols)) {
+            case UP:    pos.row--; break;
+            case DOWN:  pos.row++; break;
+            case LEFT:  pos.col--; break;
+            case RIGHT: pos.col++; break;
+        }
+    }
+    reverse(path.begin(), path.end());
+    board.placeSnake(path.data(), length, cycleDirection(path[0], rows, cols));
+}
+
+static void followCycle(GameBoard& board) {
+    Snake* snake = board.getSnake();
+    snake->setDirection(cycleDirection(snake->getHead(), board.getRows(), board.getCols()));
+}
+
+static void runSize(int rows, int cols, const vector<double>& lengths, double minSeconds,
+                    int nullFd, vector<BenchResult>& results) {
+    int capacity = (rows - 2) * (cols - 2);
+    vector<int> seen;
+
+    for (double wanted : lengths) {
+        // Values up to 1 are fractions of the interior, larger ones counts
+        int length = wanted <= 1.0 ? (int)(wanted * capacity) : (int)wanted;
+        length = max(3, min(length, capacity));
+        if (find(seen.begin(), seen.end(), length) != seen.end()) continue;
+        seen.push_back(length);
+
+        fprintf(stderr, "%dx%d length %d\n", rows, cols, length);
+        GameBoard board(rows, cols, 1);
+        placeOnCycle(board, length);
+        CellChangeList& changes = board.getChanges();
+        vector<BenchResult> batch;
+
+        batch.push_back(measure("snake_move", minSeconds, [&](long long n) {
+            Snake* snake = board.getSnake();
+            for (long long i = 0; i < n; i++) {
+                followCycle(board);
+                snake->move();
+                changes.clear();
+            }
+        }));
+
+        batch.push_back(measure("check_self_collision", minSeconds, [&](long long n) {
+            const Snake* volatile snake = board.getSnake();
+            long long hits = 0;
+            for (long long i = 0; i < n; i++) {
+                hits += snake->checkSelfCollision();
+            }
+            sink = sink + hits;
+        }));
+
+        batch.push_back(measure("check_collision", minSeconds, [&](long long n) {
+            GameBoard* volatile target = &board;
+            long long hits = 0;
+            for (long long i = 0; i < n; i++) {
+                hits += target->checkCollision();
+            }
+            sink = sink + hits;
+        }));
+
+        batch.push_back(measure("spawn_food", minSeconds, [&](long long n) {
+            for (long long i = 0; i < n; i++) {
+                board.spawnFood();
+                changes.clear();
+            }
+        }));
+
+        // Render one tick's worth of changes per frame; only the render
+        // call itself is timed
+        BoardRenderer renderer(nullFd);
+        renderer.renderInitial(board);  // 24x80 viewport, not measured
+        renderer.render(board);
+        long long frameBytes = 0;
+        long long renderNanos = 0;
+        BenchResult render = measure("render", minSeconds, [&](long long n) {
+            renderNanos = 0;
+            frameBytes = 0;
+            Snake* snake = board.getSnake();
+            for (long long i = 0; i < n; i++) {
+                followCycle(board);
+                snake->move();
+                long long start = monotonicNanos();
+                renderer.render(board);
+                renderNanos += monotonicNanos() - start;
+                frameBytes += renderer.getComposer().getLastBytes();
+            }
+        });
+        render.nsPerOp = (double)renderNanos / render.iterations;
+        render.bytesPerOp = (double)frameBytes / render.iterations;
+        batch.push_back(render);
+
+        // The interactive loop minus the sleeps: step with an action, then
+        // draw a frame, every tick. Each batch starts from the case's
+        // length, and the board starts over whenever the snake fills it
+        // and dies; those restarts are not timed or counted.
+        vector<long long> samples;
+        long long setupAllocs = 0;
+        auto restart = [&]() {
+            long long before = allocationCount;
+            board.reset(1);
+            placeOnCycle(board, length);
+            renderer.renderInitial(board);
+            renderer.render(board);
+            setupAllocs += allocationCount - before;
+        };
+        BenchResult loop = measure("full_loop", minSeconds, [&](long long n) {
+            // The sample buffer is bookkeeping; keep it out of the count
+            setupAllocs = 0;
+            long long before = allocationCount;
+            samples.clear();
+            samples.reserve(n);
+            setupAllocs += allocationCount - before;
+            restart();
+            frameBytes = 0;
+            for (long long i = 0; i < n; i++) {
+                long long start = monotonicNanos();
+                Position head = board.getSnake()->getHead();
+                if (board.step(actionFor(cycleDirection(head, rows, cols))).gameOver) {
+                    restart();
+                    continue;
+                }
+                renderer.render(board);
+                samples.push_back(monotonicNanos() - start);
+                frameBytes += renderer.getComposer().getLastBytes();
+            }
+        });
+        long long loopNanos = 0;
+        for (long long sample : samples) loopNanos += sample;
+        loop.nsPerOp = (double)loopNanos / samples.size();
+        loop.bytesPerOp = (double)frameBytes / samples.size();
+        loop.allocsPerOp -= (double)setupAllocs / loop.iterations;
+        sort(samples.begin(), samples.end());
+        loop.p50Ns = samples[samples.size() / 2];
+        loop.p99Ns = samples[min(samples.size() - 1, samples.size() * 99 / 100)];
+        loop.maxNs = samples.back();
+        batch.push_back(loop);
+
+        for (BenchResult& result : batch) {
+            result.rows = rows;
+            result.cols = cols;
+            result.length = length;
+            results.push_back(result);
+        }
+    }
+}
+
+// The parts of snake_game's loop --check-allocs covers, one pass each
+enum CheckPath {
+    CHECK_RENDER,         // autopilot, a frame drawn every tick
+    CHECK_RENDER_THREAD,  // autopilot, frames published to a RenderThread
+    CHECK_RECORD,         // autopilot and frames, every game recorded and saved
+    CHECK_MCTS,           // MCTS planner steering, frames drawn
+    CHECK_PATHS
+};
+
+static const char* const CHECK_PATH_NAMES[CHECK_PATHS] = {
+    "render", "render thread", "record", "mcts"
+};
+
+#ifdef _WIN32
+    static const char* const NULL_PATH = "NUL";
+#else
+    static const char* const NULL_PATH = "/dev/null";
+#endif
+
+// Play whole games the way the interactive loop does (a bot steering, a
+// frame every tick, the board reset between games) and count heap
+// allocations once the first game has sized every buffer and started
+// every thread. Any allocation after that, per tick or per restart, is a
+// regression. Allocations on the render and planner threads count too.
+static bool checkAllocations(int rows, int cols, int games, int nullFd, CheckPath path) {
+    GameBoard board(rows, cols, 1);
+    Autopilot autopilot(rows, cols);
+    BoardRenderer renderer(nullFd);
+    RenderThread renderThread(1, nullFd);
+    ReplayRecorder recorder(rows, cols, 1);
+    unique_ptr<MctsPlanner> planner;
+    if (path == CHECK_MCTS) planner.reset(new MctsPlanner(rows, cols, 2));
+
+    // A planner decision takes its whole budget, so those games are cut short
+    const long long tickLimit = planner ? 200 : 20LL * rows * cols;
+    const double budgetMs = 0.2;
+
+    long long tickAllocs = 0;
+    long long restartAllocs = 0;
+    long long ticks = 0;
+    long long firstBadTick = -1;
+    int firstBadRestart = -1;
+    for (int game = 0; game < games; game++) {
+        // Restart: everything between one game's last tick and the next
+        // one's first, as in Game::run()
+        long long before = allocationCount;
+        if (game > 0) {
+            if (path == CHECK_RENDER_THREAD) renderThread.stop();
+            if (path == CHECK_RECORD) recorder.save(NULL_PATH);
+            board.reset(splitmix64(game));
+        }
+        autopilot.reset();
+        if (path == CHECK_RECORD) recorder.reset(splitmix64(game));
+        renderer.renderInitial(board);
+        if (path == CHECK_RENDER_THREAD) renderThread.start(renderer, board);
+        if (game > 0 && allocationCount != before) {
+            restartAllocs += allocationCount - before;
+            if (firstBadRestart < 0) firstBadRestart = game;
+        }
+
+        for (long long t = 0; t < tickLimit && !board.isGameOver(); t++) {
+            before = allocationCount;
+            Action action = planner ? planner->nextAction(board, budgetMs)
+                                    : autopilot.nextAction(board);
+            if (path == CHECK_RECORD) recorder.record(board, action);
+            board.step(action);
+            if (path == CHECK_RENDER_THREAD) {
+                renderThread.publish(renderer, board);
+            } else {
+                renderer.render(board);
+            }
+            if (game > 0) {
+                ticks++;
+                if (allocationCount != before) {
+                    tickAllocs += allocationCount - before;
+                    if (firstBadTick < 0) firstBadTick = ticks;
+                }
+            }
+        }
+    }
+    renderThread.stop();
+
+    fprintf(stderr, "%dx%d %s: %d restarts, %lld ticks: %lld allocations in ticks, "
+                    "%lld in restarts\n", rows, cols, CHECK_PATH_NAMES[path], games - 1, ticks,
+            tickAllocs, restartAllocs);
+    if (firstBadTick >= 0) {
+        fprintf(stderr, "  first allocating tick: %lld\n", firstBadTick);
+    }
+    if (firstBadRestart >= 0) {
+        fprintf(stderr, "  first allocating restart: game %d\n", firstBadRestart);
+    }
+    return tickAllocs == 0 && restartAllocs == 0;
+}
+
+static void writeJson(FILE* out, const vector<BenchResult>& results, double minSeconds) {
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"snake_bench\",\n");
+    #ifdef __VERSION__
+        fprintf(out, "  \"compiler\": \"%s\",\n", __VERSION__);
+    #endif
+    fprintf(out, "  \"min_time_s\": %g,\n", minSeconds);
+    fprintf(out, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        fprintf(out, "    {\"case\": \"%s\", \"rows\": %d, \"cols\": %d, \"length\": %d, "
+                     "\"iterations\": %lld, \"ns_per_op\": %.2f, \"allocs_per_op\": %.4f",
+                r.name.c_str(), r.rows, r.cols, r.length, r.iterations, r.nsPerOp, r.allocsPerOp);
+        if (r.name == "render" || r.name == "full_loop") {
+            fprintf(out, ", \"bytes_per_frame\": %.1f", r.bytesPerOp);
+        }
+        if (r.name == "full_loop") {
+            fprintf(out, ", \"p50_ns\": %.0f, \"p99_ns\": %.0f, \"max_ns\": %.0f",
+                    r.p50Ns, r.p99Ns, r.maxNs);
+        }
+        fprintf(out, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+// Parse "20x40,256x256" style lists
+static bool parseSizes(const string& text, vector<pair<int, int> >& sizes) {
+    sizes.clear();
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find(',', start);
+        if (end == string::npos) end = text.size();
+        int rows = 0, cols = 0;
+        if (sscanf(text.substr(start, end - start).c_str(), "%dx%d", &rows, &cols) != 2) {
+            return false;
+        }
+        sizes.push_back(make_pair(rows, cols));
+        start = end + 1;
+    }
+    return !sizes.empty();
+}
+
+static bool parseLengths(const string& text, vector<double>& lengths) {
+    lengths.clear();
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find(',', start);
+        if (end == string::npos) end = text.size();
+        double value = atof(text.substr(start, end - start).c_str());
+        if (value <= 0) return false;
+        lengths.push_back(value);
+        start = end + 1;
+    }
+    return !lengths.empty();
+}
+
+void printUsage() {
+    cout << "Usage: snake_bench [options]" << endl;
+    cout << "  --sizes LIST      board sizes, e.g. 20x40,256x256 (rows must be even)" << endl;
+    cout << "                    default 20x40,64x64,256x256,1024x1024,4096x4096" << endl;
+    cout << "  --lengths LIST    snake lengths; values up to 1 are fractions of the" << endl;
+    cout << "                    interior, e.g. 3,0.5,1 (the default)" << endl;
+    cout << "  --min-time S      seconds per measurement (default 0.2)" << endl;
+    cout << "  --out FILE        write the JSON here instead of stdout" << endl;
+    cout << "  --check-allocs N  instead of timing, play N games per size through each" << endl;
+    cout << "                    game loop path (render, render thread, record, mcts)" << endl;
+    cout << "                    and fail if anything allocates after the first one" << endl;
+    cout << "                    (sizes default to 20x40,64x64 here)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    vector<pair<int, int> > sizes;
+    vector<double> lengths;
+    parseSizes("20x40,64x64,256x256,1024x1024,4096x4096", sizes);
+    parseLengths("3,0.5,1", lengths);
+    double minSeconds = 0.2;
+    string outPath;
+    int checkGames = 0;
+    bool sizesGiven = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--sizes" && hasValue) {
+            if (!parseSizes(argv[++i], sizes)) {
+                cerr << "Bad size list " << argv[i] << endl;
+                return 1;
+            }
+            sizesGiven = true;
+        } else if (arg == "--lengths" && hasValue) {
+            if (!parseLengths(argv[++i], lengths)) {
+                cerr << "Bad length list " << argv[i] << endl;
+                return 1;
+            }
+        } else if (arg == "--min-time" && hasValue) {
+            minSeconds = atof(argv[++i]);
+        } else if (arg == "--out" && hasValue) {
+            outPath = argv[++i];
+        } else if (arg == "--check-allocs" && hasValue) {
+            checkGames = atoi(argv[++i]);
+            if (checkGames < 2) {
+                cerr << "--check-allocs needs at least 2 games" << endl;
+                return 1;
+            }
+        } else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    // Whole games on the largest boards would take far too long
+    if (checkGames > 0 && !sizesGiven) parseSizes("20x40,64x64", sizes);
+
+    for (const pair<int, int>& size : sizes) {
+        if (size.first < MIN_BOARD_ROWS || size.second < MIN_BOARD_COLS || size.first % 2 != 0 ||
+            size.first > 32766 || size.second > 32766) {
+            cerr << "Board " << size.first << "x" << size.second
+                 << " needs an even row count between 4 and 32766 and 6 to 32766 columns" << endl;
+            return 1;
+        }
+    }
+
+    // Frames are written for real, just to somewhere that discards them
+    int nullFd = 1;
+    #ifndef _WIN32
+        nullFd = open("/dev/null", O_WRONLY);
+        if (nullFd < 0) {
+            cerr << "Cannot open /dev/null" << endl;
+            return 1;
+        }
+    #endif
+
+    if (checkGames > 0) {
+        bool clean = true;
+        for (const pair<int, int>& size : sizes) {
+            for (int path = 0; path < CHECK_PATHS; path++) {
+                clean = checkAllocations(size.first, size.second, checkGames, nullFd,
+                                         (CheckPath)path) && clean;
+            }
+        }
+        return clean ? 0 : 1;
+    }
+
+    vector<BenchResult> results;
+    for (const pair<int, int>& size : sizes) {
+        runSize(size.first, size.second, lengths, minSeconds, nullFd, results);
+    }
+
+    FILE* out = stdout;
+    if (!outPath.empty()) {
+        out = fopen(outPath.c_str(), "w");
+        if (!out) {
+            cerr << "Cannot write " << outPath << endl;
+            return 1;
+        }
+    }
+    writeJson(out, results, minSeconds);
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,215 @@
+// Compile-time specialized engine for small boards. With the size fixed
+// the whole occupancy is a few 64-bit words, the interior (non-wall) mask
+// is a constexpr table, the body is a fixed ring of cell indices and food
+// placement is a popcount walk plus a bit select, with no heap at all.
+//
+// Boards up to 64x64 only: in that range GameBoard's free cells are in
+// row-major order too, so for the same seed and actions a BitboardBoard
+// plays out exactly like a GameBoard.
+#ifndef SNAKE_BITBOARD_H
+#define SNAKE_BITBOARD_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "snake_engine.h"
+
+template <int Rows, int Cols>
+class BitboardBoard {
+    static_assert(Rows >= MIN_BOARD_ROWS && Cols >= MIN_BOARD_COLS && Rows <= 64 && Cols <= 64,
+                  "bitboard boards are 4x6 to 64x64");
+
+public:
+    static const int CELLS = Rows * Cols;
+    static const int WORDS = (CELLS + 63) / 64;
+
+private:
+    struct Mask {
+        uint64_t words[WORDS];
+    };
+
+    // Set bits = interior cells, i.e. everything but the walls
+    static constexpr Mask makeInteriorMask() {
+        Mask mask = {};
+        for (int row = 1; row < Rows - 1; row++) {
+            for (int col = 1; col < Cols - 1; col++) {
+                int cell = row * Cols + col;
+                mask.words[cell >> 6] |= 1ULL << (cell & 63);
+            }
+        }
+        return mask;
+    }
+
+    static constexpr Mask interior = makeInteriorMask();
+    static constexpr int cellDelta[4] = { -Cols, Cols, -1, 1 };
+
+    uint64_t occupied[WORDS];
+    uint16_t body[CELLS];     // ring of cell indices, head at headSlot
+    int headSlot;
+    int length;
+    int food;                 // cell index, -1 once the board is full
+    int freeCount;
+    Direction direction;
+    bool growing;
+    bool selfCollided;
+    Rng rng;
+    int score;
+    int highScore;
+    bool gameOver;
+
+    static bool isInterior(int cell) {
+        return (interior.words[cell >> 6] >> (cell & 63)) & 1;
+    }
+
+    bool isSet(int cell) const {
+        return (occupied[cell >> 6] >> (cell & 63)) & 1;
+    }
+
+    void occupy(int cell) {
+        uint64_t bit = 1ULL << (cell & 63);
+        if (!(occupied[cell >> 6] & bit)) {
+            occupied[cell >> 6] |= bit;
+            if (isInterior(cell)) freeCount--;
+        }
+    }
+
+    void release(int cell) {
+        uint64_t bit = 1ULL << (cell & 63);
+        if (occupied[cell >> 6] & bit) {
+            occupied[cell >> 6] &= ~bit;
+            if (isInterior(cell)) freeCount++;
+        }
+    }
+
+    int tailCell() const {
+        int slot = headSlot + length - 1;
+        if (slot >= CELLS) slot -= CELLS;
+        return body[slot];
+    }
+
+public:
+    // Size arguments exist so generic code can construct either engine
+    // the same way; they must match the template
+    BitboardBoard(int r = Rows, int c = Cols, uint64_t seed = 0) : highScore(0) {
+        (void)r;
+        (void)c;
+        reset(seed);
+    }
+
+    static const char* engineName() { return "bitboard"; }
+
+    // Start a new game with the usual layout: length 3 in the middle,
+    // heading right. The high score carries over, as in GameBoard.
+    void reset(uint64_t seed) {
+        for (int w = 0; w < WORDS; w++) occupied[w] = 0;
+        freeCount = (Rows - 2) * (Cols - 2);
+        headSlot = 0;
+        length = 3;
+        int start = (Rows / 2) * Cols + Cols / 2;
+        for (int i = 0; i < length; i++) {
+            body[i] = start - i;
+            occupy(start - i);
+        }
+        direction = RIGHT;
+        growing = false;
+        selfCollided = false;
+        rng.reseed(seed);
+        score = 0;
+        gameOver = false;
+        spawnFood();
+    }
+
+    void spawnFood() {
+        if (freeCount <= 0) {
+            food = -1;
+            return;
+        }
+        int target = rng.nextBelow(freeCount);
+        for (int w = 0; w < WORDS; w++) {
+            uint64_t freeBits = interior.words[w] & ~occupied[w];
+            int n = __builtin_popcountll(freeBits);
+            if (target < n) {
+                food = w * 64 + selectBit(freeBits, target);
+                return;
+            }
+            target -= n;
+        }
+    }
+
+    // Same rules as GameBoard::step: bytes outside ACTION_UP..ACTION_RIGHT
+    // keep the current direction
+    StepResult step(Action action) {
+        if (action >= ACTION_UP && action <= ACTION_RIGHT) {
+            Direction wanted = (Direction)(action - ACTION_UP);
+            if (wanted != (direction ^ 1)) direction = wanted;
+        }
+
+        StepResult result = { false, gameOver };
+        if (gameOver) return result;
+
+        // Tail leaves before the head lands
+        int head = body[headSlot];
+        int newHead = head + cellDelta[direction];
+        if (!growing) {
+            release(tailCell());
+        } else {
+            length++;
+            growing = false;
+        }
+        headSlot = (headSlot == 0 ? CELLS : headSlot) - 1;
+        body[headSlot] = newHead;
+        selfCollided = isSet(newHead);
+        occupy(newHead);
+
+        if (!isInterior(newHead) || selfCollided) {
+            gameOver = true;
+            if (score > highScore) highScore = score;
+        } else if (newHead == food) {
+            growing = true;
+            score += 10;
+            spawnFood();
+            result.ateFood = true;
+        }
+        result.gameOver = gameOver;
+        return result;
+    }
+
+    Position getHead() const { return Position(body[headSlot] / Cols, body[headSlot] % Cols); }
+    Position getTail() const { return Position(tailCell() / Cols, tailCell() % Cols); }
+    Position getFoodPosition() const {
+        return food < 0 ? Position(-1, -1) : Position(food / Cols, food % Cols);
+    }
+    bool isOccupied(Position pos) const { return isSet(pos.row * Cols + pos.col); }
+    Direction getDirection() const { return direction; }
+
+    int getRows() const { return Rows; }
+    int getCols() const { return Cols; }
+    bool isGameOver() const { return gameOver; }
+    int getScore() const { return score; }
+    int getHighScore() const { return highScore; }
+    int getSnakeLength() const { return length; }
+
+    // Everything lives inline in the object
+    size_t getMemoryUsage() const { return sizeof(*this); }
+};
+
+// Runtime dispatch: calls f with a null pointer whose type names the
+// engine for the size, a BitboardBoard when that size is compiled in and
+// GameBoard otherwise. Generic code then instantiates itself for it:
+//
+//     dispatchBoard(rows, cols, [&](auto* type) {
+//         typedef std::remove_pointer_t<decltype(type)> Board;
+//         ...
+//     });
+template <typename F>
+auto dispatchBoard(int rows, int cols, F&& f) -> decltype(f((GameBoard*)nullptr)) {
+    if (rows == 10 && cols == 10) return f((BitboardBoard<10, 10>*)nullptr);
+    if (rows == 20 && cols == 20) return f((BitboardBoard<20, 20>*)nullptr);
+    if (rows == 20 && cols == 40) return f((BitboardBoard<20, 40>*)nullptr);
+    if (rows == 22 && cols == 40) return f((BitboardBoard<22, 40>*)nullptr);
+    if (rows == 32 && cols == 32) return f((BitboardBoard<32, 32>*)nullptr);
+    if (rows == 64 && cols == 64) return f((BitboardBoard<64, 64>*)nullptr);
+    return f((GameBoard*)nullptr);
+}
+
+#endif
@@ -0,0 +1,207 @@
+// Stand-in multiplayer client: connects any number of greedy bots to a
+// snake_server from one poll() loop. Each bot keeps its own BoardMirror
+// from the snapshot and deltas and steers toward the nearest food it can
+// reach without hitting anything this tick. Reports the traffic it saw.
+#include <iostream>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#ifndef _WIN32
+    #include <poll.h>
+    #include <unistd.h>
+#endif
+
+#include "snake_net.h"
+
+using namespace std;
+
+#ifndef _WIN32
+
+struct Bot {
+    int fd;
+    FrameReader in;
+    BoardMirror mirror;
+    vector<uint8_t> out;
+    long long bytes;
+    long long deltas;
+    int deaths;
+    int bestScore;
+    bool wasAlive;
+};
+
+// Safe move nearest a food, or keep going if nothing is safe
+static Direction chooseDirection(const BoardMirror& mirror) {
+    Position head = mirror.getHead();
+    Direction current = mirror.getDirection();
+    Direction best = current;
+    int bestDistance = 1 << 30;
+    for (int d = 0; d < 4; d++) {
+        if (d == (current ^ 1)) continue;
+        Position next = stepFrom(head, (Direction)d);
+        if (next.row <= 0 || next.row >= mirror.getRows() - 1 ||
+            next.col <= 0 || next.col >= mirror.getCols() - 1) {
+            continue;
+        }
+        CellKind kind = mirror.getCell(next);
+        if (kind == CELL_HEAD || kind == CELL_BODY) continue;
+
+        int distance = 1 << 29;
+        for (const Position& food : mirror.getFoods()) {
+            distance = min(distance, abs(next.row - food.row) + abs(next.col - food.col));
+        }
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = (Direction)d;
+        }
+    }
+    return best;
+}
+
+// Take in whatever has arrived; false once the server has gone
+static bool readMessages(Bot& bot) {
+    uint8_t buffer[65536];
+    bool open = true;
+    while (true) {
+        ssize_t n = read(bot.fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            bot.in.append(buffer, n);
+            bot.bytes += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            open = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+            break;
+        }
+    }
+
+    const uint8_t* payload;
+    uint32_t size;
+    bool updated = false;
+    while (bot.in.next(payload, size)) {
+        if (!bot.mirror.apply(payload, size)) {
+            cerr << "Malformed message from the server" << endl;
+            return false;
+        }
+        if (payload[0] == MSG_DELTA) bot.deltas++;
+        updated = true;
+    }
+    if (!updated || !bot.mirror.isReady()) return open;
+
+    int id = bot.mirror.getYourId();
+    bool alive = bot.mirror.isAlive(id);
+    if (bot.wasAlive && !alive) bot.deaths++;
+    bot.wasAlive = alive;
+    bot.bestScore = max(bot.bestScore, bot.mirror.getScore(id));
+
+    // Only turns go out; the server keeps the heading otherwise
+    if (alive) {
+        Direction dir = chooseDirection(bot.mirror);
+        if (dir != bot.mirror.getDirection()) {
+            bot.out.clear();
+            encodeTurn(actionFor(dir), bot.out);
+            if (write(bot.fd, bot.out.data(), bot.out.size()) < 0 && errno != EAGAIN) return false;
+        }
+    }
+    return open;
+}
+
+static void printUsage() {
+    cout << "Usage: snake_client [options]" << endl;
+    cout << "  --connect ADDR    unix:PATH or tcp:PORT (default unix:/tmp/snake.sock)" << endl;
+    cout << "  --bots N          bots to connect (default 1)" << endl;
+    cout << "  --ticks N         disconnect after N ticks (default: until the server stops)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    string address = "unix:/tmp/snake.sock";
+    int botCount = 1;
+    long long maxTicks = 0;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--connect" && hasValue) {
+            address = argv[++i];
+        } else if (arg == "--bots" && hasValue) {
+            botCount = atoi(argv[++i]);
+        } else if (arg == "--ticks" && hasValue) {
+            maxTicks = atoll(argv[++i]);
+        } else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    vector<unique_ptr<Bot> > bots;
+    for (int i = 0; i < botCount; i++) {
+        int fd = connectTo(address);
+        if (fd < 0 || !setNonBlocking(fd)) return 1;
+        Bot* bot = new Bot();
+        bot->fd = fd;
+        bot->bytes = 0;
+        bot->deltas = 0;
+        bot->deaths = 0;
+        bot->bestScore = 0;
+        bot->wasAlive = false;
+        bots.emplace_back(bot);
+    }
+
+    vector<pollfd> fds(bots.size());
+    int open = bots.size();
+    while (open > 0) {
+        for (size_t i = 0; i < bots.size(); i++) {
+            fds[i].fd = bots[i]->fd;
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+        if (poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+        for (size_t i = 0; i < bots.size(); i++) {
+            Bot& bot = *bots[i];
+            if (bot.fd < 0 || !(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            bool done = maxTicks > 0 && bot.deltas >= maxTicks;
+            if (!readMessages(bot) || done) {
+                close(bot.fd);
+                bot.fd = -1;     // poll() skips negative descriptors
+                open--;
+            }
+        }
+    }
+
+    long long bytes = 0;
+    long long deltas = 0;
+    int deaths = 0;
+    int bestScore = 0;
+    for (const unique_ptr<Bot>& bot : bots) {
+        bytes += bot->bytes;
+        deltas += bot->deltas;
+        deaths += bot->deaths;
+        bestScore = max(bestScore, bot->bestScore);
+    }
+    cout << "Bots:         " << bots.size() << endl;
+    cout << "Ticks seen:   " << (bots.empty() ? 0 : deltas / (long long)bots.size()) << " per bot" << endl;
+    if (deltas > 0) {
+        cout << "Received:     " << bytes << " bytes (" << (double)bytes / deltas << " per bot per tick)" << endl;
+    }
+    cout << "Deaths:       " << deaths << endl;
+    cout << "Best score:   " << bestScore << endl;
+    return 0;
+}
+
+#else
+
+int main() {
+    cerr << "snake_client needs POSIX sockets" << endl;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,528 @@
+#include "snake_engine.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Little helpers for the state snapshot format (host byte order)
+template <typename T>
+static void putValue(vector<uint8_t>& out, T value) {
+    size_t at = out.size();
+    out.resize(at + sizeof(T));
+    memcpy(&out[at], &value, sizeof(T));
+}
+
+template <typename T>
+static bool getValue(const uint8_t*& p, const uint8_t* end, T& value) {
+    if ((size_t)(end - p) < sizeof(T)) return false;
+    memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+OccupancyGrid::OccupancyGrid(int r, int c, int borderMargin)
+    : rows(r), cols(c), margin(borderMargin), tileCols((c + 63) / 64),
+      tileCount(((r + 63) / 64) * tileCols), freeCount(0), bits((size_t)tileCount * 64, 0),
+      columnMasks(tileCols), wordFree((size_t)tileCount * 64),
+      tileFree(tileCount), fenwick(tileCount + 1) {
+    for (int tc = 0; tc < tileCols; tc++) {
+        int first = max(margin, tc * 64) - tc * 64;
+        int last = min(cols - 1 - margin, tc * 64 + 63) - tc * 64;
+        uint64_t mask = 0;
+        for (int bit = first; bit <= last; bit++) {
+            mask |= 1ULL << bit;
+        }
+        columnMasks[tc] = mask;
+    }
+    fenwickTop = 1;
+    while (fenwickTop * 2 <= tileCount) fenwickTop *= 2;
+    clear();
+}
+
+void OccupancyGrid::clear() {
+    if (walls.empty()) {
+        fill(bits.begin(), bits.end(), 0);
+    } else {
+        copy(walls.begin(), walls.end(), bits.begin());
+    }
+
+    // Every interior cell that is not a wall is free; rebuild the tile
+    // counts and the tree
+    freeCount = 0;
+    for (int tile = 0; tile < tileCount; tile++) {
+        int tr = tile / tileCols;
+        int firstRow = max(margin, tr * 64);
+        int lastRow = min(rows - 1 - margin, tr * 64 + 63);
+        uint64_t mask = columnMasks[tile % tileCols];
+        int free = 0;
+        for (int w = 0; w < 64; w++) {
+            int row = tr * 64 + w;
+            size_t index = ((size_t)tile << 6) | w;
+            int n = row >= firstRow && row <= lastRow ? __builtin_popcountll(mask & ~bits[index]) : 0;
+            wordFree[index] = n;
+            free += n;
+        }
+        tileFree[tile] = free;
+        fenwick[tile + 1] = free;
+        freeCount += free;
+    }
+    for (int i = 1; i <= tileCount; i++) {
+        int parent = i + (i & -i);
+        if (parent <= tileCount) fenwick[parent] += fenwick[i];
+    }
+}
+
+void OccupancyGrid::adjustFree(int tile, int delta) {
+    tileFree[tile] += delta;
+    freeCount += delta;
+    for (int i = tile + 1; i <= tileCount; i += i & -i) {
+        fenwick[i] += delta;
+    }
+}
+
+void OccupancyGrid::occupy(Position pos) {
+    size_t index = wordOf(pos);
+    uint64_t bit = 1ULL << (pos.col & 63);
+    if (!(bits[index] & bit)) {
+        bits[index] |= bit;
+        if (isInterior(pos)) {
+            wordFree[index]--;
+            adjustFree(tileOf(pos), -1);
+        }
+    }
+}
+
+void OccupancyGrid::release(Position pos) {
+    size_t index = wordOf(pos);
+    uint64_t bit = 1ULL << (pos.col & 63);
+    if (bits[index] & bit) {
+        bits[index] &= ~bit;
+        if (isInterior(pos)) {
+            wordFree[index]++;
+            adjustFree(tileOf(pos), 1);
+        }
+    }
+}
+
+void OccupancyGrid::addWall(Position pos) {
+    if (walls.empty()) walls.assign(bits.size(), 0);
+    walls[wordOf(pos)] |= 1ULL << (pos.col & 63);
+    occupy(pos);
+}
+
+Position OccupancyGrid::getFreeCell(int i) const {
+    // Descend the Fenwick tree to the tile holding the i-th free cell
+    int tile = 0;
+    int remaining = i;
+    for (int step = fenwickTop; step > 0; step >>= 1) {
+        int next = tile + step;
+        int count = next <= tileCount ? fenwick[next] : remaining + 1;
+        int take = count <= remaining;
+        tile += take * step;
+        remaining -= take * count;
+    }
+
+    // Then walk that tile's row counts and select within the row
+    size_t first = (size_t)tile << 6;
+    for (int w = 0; w < 64; w++) {
+        int n = wordFree[first + w];
+        if (remaining < n) {
+            uint64_t free = ~bits[first + w] & columnMasks[tile % tileCols];
+            return Position((tile / tileCols) * 64 + w,
+                            (tile % tileCols) * 64 + selectBit(free, remaining));
+        }
+        remaining -= n;
+    }
+    return Position(-1, -1);
+}
+
+size_t OccupancyGrid::getMemoryUsage() const {
+    return bits.capacity() * sizeof(uint64_t) + columnMasks.capacity() * sizeof(uint64_t) +
+           wordFree.capacity() +
+           tileFree.capacity() * sizeof(uint16_t) + fenwick.capacity() * sizeof(int32_t) +
+           walls.capacity() * sizeof(uint64_t);
+}
+
+Direction cycleDirection(Position pos, int rows, int cols) {
+    int i = pos.row - 1;
+    int j = pos.col - 1;
+    int h = rows - 2;
+    int w = cols - 2;
+
+    if (j == 0) return i == 0 ? RIGHT : UP;
+    if (i % 2 == 0) return j == w - 1 ? DOWN : RIGHT;
+    if (j == 1) return i == h - 1 ? LEFT : DOWN;
+    return LEFT;
+}
+
+template <typename Topology>
+BasicSnake<Topology>::BasicSnake(Position startPos, OccupancyGrid* occupancy,
+                                 CellChangeList* changeList, int capacity, int initialLength)
+    : trail((capacity + 3) / 4, 0), capacity(capacity), rows(occupancy->getRows()),
+      cols(occupancy->getCols()), grid(occupancy), changes(changeList),
+      headSymbol('#'), bodySymbol('o') {
+    reset(startPos, initialLength);
+}
+
+template <typename Topology>
+void BasicSnake<Topology>::reset(Position startPos, int initialLength) {
+    headIndex = 0;
+    length = initialLength;
+    head = startPos;
+    tail = startPos;
+    direction = RIGHT;
+    growing = false;
+    selfCollided = false;
+
+    // Initialize snake body (horizontal line, every segment entered moving right)
+    for (int i = 0; i < length; i++) {
+        setTrail(i, RIGHT);
+        if (i > 0) tail = Topology::step(tail, LEFT, rows, cols);
+        grid->occupy(tail);
+        changes->add(tail, i == 0 ? CELL_HEAD : CELL_BODY);
+    }
+    rehash();
+}
+
+template <typename Topology>
+void BasicSnake<Topology>::setDirection(Direction newDir) {
+    // Prevent moving in opposite direction
+    if (newDir == opposite(direction)) {
+        return;
+    }
+    hash ^= motionKey();
+    direction = newDir;
+    hash ^= motionKey();
+}
+
+template <typename Topology>
+void BasicSnake<Topology>::restore(const Position* cells, int count, Direction dir, bool grow,
+                                   bool collided) {
+    headIndex = 0;
+    length = count;
+    head = cells[0];
+    tail = cells[count - 1];
+    for (int i = 0; i + 1 < count; i++) {
+        setTrail(i, stepDirection<Topology>(cells[i + 1], cells[i], rows, cols));
+    }
+    direction = dir;
+    growing = grow;
+    selfCollided = collided;
+    rehash();
+}
+
+template <typename Topology>
+void BasicSnake<Topology>::rehash() {
+    hash = zobristKey(ZOBRIST_HEAD, head) ^ zobristKey(ZOBRIST_TAIL, tail) ^ motionKey();
+    for (const Position& pos : getBody()) {
+        hash ^= zobristKey(ZOBRIST_BODY, pos);
+    }
+}
+
+template <typename Topology>
+void BasicSnake<Topology>::vacateTail() {
+    // Tail leaves before the head lands, so following it is legal. The
+    // new tail is the segment the old one led into.
+    hash ^= motionKey();
+    if (!growing) {
+        grid->release(tail);
+        changes->add(tail, CELL_EMPTY);
+        int slot = headIndex + length - 2;
+        if (slot >= capacity) slot -= capacity;
+        hash ^= zobristKey(ZOBRIST_BODY, tail) ^ zobristKey(ZOBRIST_TAIL, tail);
+        tail = Topology::step(tail, trailAt(slot), rows, cols);
+        hash ^= zobristKey(ZOBRIST_TAIL, tail);
+    } else {
+        length++;
+        growing = false;
+    }
+    hash ^= motionKey();
+}
+
+template <typename Topology>
+void BasicSnake<Topology>::advanceHead() {
+    Position oldHead = head;
+    Position newHead = Topology::step(head, direction, rows, cols);
+    headIndex = (headIndex == 0 ? capacity : headIndex) - 1;
+    setTrail(headIndex, direction);
+    head = newHead;
+    hash ^= zobristKey(ZOBRIST_HEAD, oldHead) ^ zobristKey(ZOBRIST_HEAD, newHead) ^
+            zobristKey(ZOBRIST_BODY, newHead);
+
+    selfCollided = grid->isOccupied(newHead);
+    grid->occupy(newHead);
+    changes->add(oldHead, CELL_BODY);
+    changes->add(newHead, CELL_HEAD);
+}
+
+template <typename Topology>
+BasicGameBoard<Topology>::BasicGameBoard(int r, int c, uint64_t seed)
+    : rows(r), cols(c), grid(r, c, Topology::MARGIN),
+      snake(Position(r / 2, c / 2), &grid, &changes, r * c), rng(seed), score(0),
+      highScore(0), gameOver(false) {
+    spawnFood();
+}
+
+template <typename Topology>
+BasicGameBoard<Topology>::BasicGameBoard(const BasicGameBoard& other)
+    : rows(other.rows), cols(other.cols), grid(other.grid), changes(other.changes),
+      snake(other.snake), food(other.food), rng(other.rng), score(other.score),
+      highScore(other.highScore), gameOver(other.gameOver) {
+    snake.rebind(&grid, &changes);
+}
+
+template <typename Topology>
+BasicGameBoard<Topology>& BasicGameBoard<Topology>::operator=(const BasicGameBoard& other) {
+    if (this == &other) return *this;
+    rows = other.rows;
+    cols = other.cols;
+    grid = other.grid;
+    changes = other.changes;
+    snake = other.snake;
+    snake.rebind(&grid, &changes);
+    food = other.food;
+    rng = other.rng;
+    score = other.score;
+    highScore = other.highScore;
+    gameOver = other.gameOver;
+    return *this;
+}
+
+template <typename Topology>
+void BasicGameBoard<Topology>::reset(uint64_t seed) {
+    grid.clear();
+    changes.clear();
+    snake.reset(Position(rows / 2, cols / 2));
+    rng.reseed(seed);
+    score = 0;
+    gameOver = false;
+    spawnFood();
+
+    // Whatever was on screen belongs to the last game
+    changes.invalidate();
+}
+
+template <typename Topology>
+void BasicGameBoard<Topology>::spawnFood() {
+    // Pick straight from the free-cell index
+    int freeCount = grid.getFreeCount();
+    if (freeCount > 0) {
+        food.setPosition(grid.getFreeCell(rng.nextBelow(freeCount)));
+        changes.add(food.getPosition(), CELL_FOOD);
+    } else {
+        // Board is full; park the food off the board so it cannot be eaten
+        food.setPosition(Position(-1, -1));
+    }
+}
+
+template <typename Topology>
+void BasicGameBoard<Topology>::placeSnake(const Position* body, int count, Direction dir) {
+    // Only the snake and the walls occupy cells, so this clears the old body
+    grid.clear();
+    for (int i = 0; i < count; i++) {
+        grid.occupy(body[i]);
+    }
+    snake.restore(body, count, dir, false, false);
+
+    if (food.getPosition().row < 0 || grid.isOccupied(food.getPosition())) {
+        spawnFood();
+    }
+    changes.invalidate();
+}
+
+template <typename Topology>
+StepResult BasicGameBoard<Topology>::step(Action action) {
+    if (action >= ACTION_UP && action <= ACTION_RIGHT) {
+        snake.setDirection((Direction)(action - ACTION_UP));
+    }
+
+    StepResult result = { false, gameOver };
+    if (!gameOver) {
+        snake.move();
+
+        if (checkCollision()) {
+            gameOver = true;
+            if (score > highScore) {
+                highScore = score;
+            }
+        } else {
+            result.ateFood = checkFoodCollision();
+        }
+        result.gameOver = gameOver;
+    }
+    return result;
+}
+
+template <typename Topology>
+void BasicGameBoard<Topology>::saveState(vector<uint8_t>& out) const {
+    putValue<uint16_t>(out, rows);
+    putValue<uint16_t>(out, cols);
+    putValue<uint64_t>(out, rng.getState());
+    putValue<int32_t>(out, score);
+    putValue<int32_t>(out, highScore);
+    putValue<uint8_t>(out, gameOver);
+    putValue<uint8_t>(out, snake.getDirection());
+    putValue<uint8_t>(out, snake.isGrowing());
+    putValue<uint8_t>(out, snake.checkSelfCollision());
+    putValue<int16_t>(out, food.getPosition().row);
+    putValue<int16_t>(out, food.getPosition().col);
+
+    // Body as the head plus 2-bit steps towards it, four per byte; the
+    // occupancy grid and free-cell counts follow from the body
+    int length = snake.getLength();
+    putValue<int32_t>(out, length);
+    putValue<int16_t>(out, snake.getHead().row);
+    putValue<int16_t>(out, snake.getHead().col);
+    size_t at = out.size();
+    out.resize(at + (length - 1 + 3) / 4, 0);
+    Position previous = snake.getHead();
+    int k = -1;
+    for (const Position& pos : snake.getBody()) {
+        if (k >= 0) {
+            int dir = stepDirection<Topology>(pos, previous, rows, cols);
+            out[at + (k >> 2)] |= dir << ((k & 3) * 2);
+        }
+        previous = pos;
+        k++;
+    }
+}
+
+template <typename Topology>
+bool BasicGameBoard<Topology>::loadState(const uint8_t* data, size_t size) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    uint16_t savedRows, savedCols;
+    uint64_t rngState;
+    int32_t savedScore, savedHighScore, length;
+    int16_t headRow, headCol;
+    uint8_t savedGameOver, direction, growing, collided;
+    int16_t foodRow, foodCol;
+
+    if (!getValue(p, end, savedRows) || !getValue(p, end, savedCols) ||
+        savedRows != rows || savedCols != cols ||
+        !getValue(p, end, rngState) || !getValue(p, end, savedScore) ||
+        !getValue(p, end, savedHighScore) || !getValue(p, end, savedGameOver) ||
+        !getValue(p, end, direction) || !getValue(p, end, growing) ||
+        !getValue(p, end, collided) || !getValue(p, end, foodRow) ||
+        !getValue(p, end, foodCol) || !getValue(p, end, length) ||
+        length < 2 || length > rows * cols || direction > RIGHT ||
+        !getValue(p, end, headRow) || !getValue(p, end, headCol) ||
+        (size_t)(end - p) < (size_t)(length - 1 + 3) / 4) {
+        return false;
+    }
+
+    vector<Position> body(length);
+    body[0] = Position(headRow, headCol);
+    for (int k = 0; k < length; k++) {
+        if (k > 0) {
+            Direction dir = (Direction)((p[(k - 1) >> 2] >> (((k - 1) & 3) * 2)) & 3);
+            body[k] = Topology::step(body[k - 1], opposite(dir), rows, cols);
+        }
+        if (body[k].row < 0 || body[k].row >= rows || body[k].col < 0 || body[k].col >= cols) {
+            return false;
+        }
+    }
+
+    // The grid is rebuilt from the body, so every segment has to be on the
+    // field, off the walls and on a cell of its own. Only the head of a
+    // finished game may have run into a wall, the border or the body.
+    vector<int> cells;
+    cells.reserve(length);
+    for (int k = 0; k < length; k++) {
+        if (k == 0 && savedGameOver) continue;
+        if (!grid.isInterior(body[k]) || grid.isWall(body[k])) return false;
+        cells.push_back(body[k].row * cols + body[k].col);
+    }
+    sort(cells.begin(), cells.end());
+    if (adjacent_find(cells.begin(), cells.end()) != cells.end()) {
+        return false;
+    }
+
+    // Food is on a free cell, or parked at (-1, -1) when the board is full
+    Position savedFood(foodRow, foodCol);
+    if (!(foodRow == -1 && foodCol == -1) &&
+        (foodRow < 0 || foodRow >= rows || foodCol < 0 || foodCol >= cols ||
+         !grid.isInterior(savedFood) || grid.isWall(savedFood) || savedFood == body[0] ||
+         binary_search(cells.begin(), cells.end(), foodRow * cols + foodCol))) {
+        return false;
+    }
+
+    grid.clear();
+    for (const Position& pos : body) {
+        grid.occupy(pos);
+    }
+    snake.restore(body.data(), length, (Direction)direction, growing, collided);
+    food.setPosition(savedFood);
+    rng.setState(rngState);
+    score = savedScore;
+    highScore = savedHighScore;
+    gameOver = savedGameOver;
+
+    // Whatever was on screen no longer matches; have the renderer repaint
+    changes.invalidate();
+    return true;
+}
+
+template <typename Topology>
+bool BasicGameBoard<Topology>::checkCollision() {
+    // Boundary collision; never true on a torus
+    if (Topology::isOffField(snake.getHead(), rows, cols)) {
+        return true;
+    }
+
+    // Self collision, or an obstacle
+    if (snake.checkSelfCollision()) {
+        return true;
+    }
+
+    return false;
+}
+
+template <typename Topology>
+bool BasicGameBoard<Topology>::checkFoodCollision() {
+    if (snake.getHead() == food.getPosition()) {
+        snake.grow();
+        score += 10;
+        spawnFood();
+        return true;  // Food was eaten
+    }
+    return false;
+}
+
+template <typename Topology>
+void BasicGameBoard<Topology>::update() {
+    step(ACTION_NONE);
+}
+
+template <typename Topology>
+bool BasicGameBoard<Topology>::didEatFood() {
+    // Check if food was just eaten
+    if (!gameOver) {
+        return checkFoodCollision();
+    }
+    return false;
+}
+
+template <typename Topology>
+bool BasicGameBoard<Topology>::addWall(Position pos) {
+    // Only obstacle boards have walls; the constant folds this away
+    if (!Topology::HAS_OBSTACLES) return false;
+
+    Position start(rows / 2, cols / 2);
+    bool onStart = pos.row == start.row && pos.col <= start.col && pos.col >= start.col - 2;
+    if (!grid.isInterior(pos) || onStart || grid.isOccupied(pos)) {
+        return false;
+    }
+    grid.addWall(pos);
+    if (pos == food.getPosition()) spawnFood();
+    changes.invalidate();
+    return true;
+}
+
+template class BasicSnake<BoundedTopology>;
+template class BasicSnake<TorusTopology>;
+template class BasicSnake<ObstacleTopology>;
+template class BasicGameBoard<BoundedTopology>;
+template class BasicGameBoard<TorusTopology>;
+template class BasicGameBoard<ObstacleTopology>;
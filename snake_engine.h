@@ -0,0 +1,650 @@
+// Headless snake simulation: board, snake, food and the per-tick rules.
+// Nothing in here touches the terminal, so the engine can be stepped as
+// fast as the CPU allows by drivers, bots and the interactive frontend.
+#ifndef SNAKE_ENGINE_H
+#define SNAKE_ENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef __BMI2__
+    #include <immintrin.h>
+#endif
+
+// Enum for directions. Opposites differ only in the low bit, so the
+// reverse of d is d ^ 1.
+enum Direction {
+    UP,
+    DOWN,
+    LEFT,
+    RIGHT
+};
+
+inline Direction opposite(Direction dir) {
+    return (Direction)(dir ^ 1);
+}
+
+// Input to one simulation step; ACTION_NONE keeps the current heading.
+// Every engine (GameBoard, BitboardBoard, VectorEnv) treats a value past
+// ACTION_RIGHT the same way, so action bytes from outside need no check.
+enum Action {
+    ACTION_NONE,
+    ACTION_UP,
+    ACTION_DOWN,
+    ACTION_LEFT,
+    ACTION_RIGHT
+};
+
+// Action that turns the snake towards dir
+inline Action actionFor(Direction dir) {
+    return (Action)(ACTION_UP + dir);
+}
+
+// Outcome of one simulation step
+struct StepResult {
+    bool ateFood;
+    bool gameOver;
+};
+
+// splitmix64 finalizer, used to turn seeds into well-mixed PRNG states
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Index of the k-th set bit of x (k < popcount(x)). With BMI2 enabled at
+// build time this is a single pdep; otherwise the search window is halved
+// by popcount, without branches since k is random, down to one byte.
+inline int selectBit(uint64_t x, int k) {
+    #ifdef __BMI2__
+        return __builtin_ctzll(_pdep_u64(1ULL << k, x));
+    #else
+        int base = 0;
+        for (int width = 32; width >= 8; width >>= 1) {
+            int n = __builtin_popcountll((x >> base) & ((1ULL << width) - 1));
+            int upper = k >= n;
+            k -= upper * n;
+            base += upper * width;
+        }
+        uint64_t byte = (x >> base) & 0xFF;
+        while (k-- > 0) byte &= byte - 1;
+        return base + __builtin_ctzll(byte);
+    #endif
+}
+
+// Per-instance xorshift64* generator, so boards with the same seed play
+// out identically regardless of what else is using random numbers
+class Rng {
+private:
+    uint64_t state;
+
+public:
+    explicit Rng(uint64_t seed = 0) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        state = splitmix64(seed);
+        if (state == 0) state = 0x9E3779B97F4A7C15ULL;
+    }
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
+
+    // Uniform integer in [0, bound)
+    uint32_t nextBelow(uint32_t bound) {
+        return (uint32_t)(((next() >> 32) * bound) >> 32);
+    }
+
+    uint64_t getState() const { return state; }
+    void setState(uint64_t s) { state = s; }
+};
+
+// Class representing a position (packed to 4 bytes so the body is cache-dense)
+class Position {
+public:
+    int16_t row;
+    int16_t col;
+
+    Position(int r = 0, int c = 0) : row(r), col(c) {}
+
+    bool operator==(const Position& other) const {
+        return row == other.row && col == other.col;
+    }
+};
+
+// Zobrist keys for state hashing. Keys are derived from the cell with
+// splitmix64 instead of being looked up, so there is no per-cell table.
+enum ZobristKind {
+    ZOBRIST_BODY,
+    ZOBRIST_HEAD,
+    ZOBRIST_TAIL,
+    ZOBRIST_FOOD,
+    ZOBRIST_MOTION      // pos holds (direction, growing)
+};
+
+inline uint64_t zobristKey(ZobristKind kind, Position pos) {
+    return splitmix64(((uint64_t)(uint16_t)pos.row << 32) | ((uint64_t)(uint16_t)pos.col << 8) |
+                      (uint64_t)kind);
+}
+
+// Neighbouring cell one step in the given direction
+inline Position stepFrom(Position pos, Direction dir) {
+    static const int8_t rowDelta[4] = { -1, 1, 0, 0 };
+    static const int8_t colDelta[4] = { 0, 0, -1, 1 };
+    return Position(pos.row + rowDelta[dir], pos.col + colDelta[dir]);
+}
+
+// Board topologies, chosen at compile time by BasicGameBoard. A policy
+// gives the width of the wall ring around the board (MARGIN), where a step
+// from a cell leads, and which cells are off the playing field. Everything
+// is static and inline, so a tick costs nothing extra for the choice.
+struct BoundedTopology {
+    static const int MARGIN = 1;
+    static const bool HAS_OBSTACLES = false;
+
+    static const char* engineName() { return "generic"; }
+
+    static Position step(Position pos, Direction dir, int, int) {
+        return stepFrom(pos, dir);
+    }
+
+    static bool isOffField(Position pos, int rows, int cols) {
+        return pos.row <= 0 || pos.row >= rows - 1 || pos.col <= 0 || pos.col >= cols - 1;
+    }
+};
+
+// No walls: leaving one edge brings the snake in at the opposite one. The
+// wrap is a conditional add or subtract, never a division.
+struct TorusTopology {
+    static const int MARGIN = 0;
+    static const bool HAS_OBSTACLES = false;
+
+    static const char* engineName() { return "torus"; }
+
+    static Position step(Position pos, Direction dir, int rows, int cols) {
+        Position next = stepFrom(pos, dir);
+        next.row += next.row < 0 ? rows : next.row >= rows ? -rows : 0;
+        next.col += next.col < 0 ? cols : next.col >= cols ? -cols : 0;
+        return next;
+    }
+
+    static bool isOffField(Position, int, int) {
+        return false;
+    }
+};
+
+// Bounded, with wall cells inside the board too. The occupancy grid keeps
+// them as cells that are always occupied, so running into one is caught by
+// the same bit test as running into the body.
+struct ObstacleTopology : BoundedTopology {
+    static const bool HAS_OBSTACLES = true;
+
+    static const char* engineName() { return "obstacle-map"; }
+};
+
+// Direction of the single step that leads from one cell to its neighbour
+template <typename Topology>
+Direction stepDirection(Position from, Position to, int rows, int cols) {
+    for (int d = UP; d < RIGHT; d++) {
+        if (Topology::step(from, (Direction)d, rows, cols) == to) return (Direction)d;
+    }
+    return RIGHT;
+}
+
+// Occupancy grid: one bit per cell, stored as 64x64 tiles (one 64-bit
+// word per tile row) so any board region is a handful of cache lines.
+// Free interior cells are counted per tile row and per tile, with a
+// Fenwick tree over the tiles, so marking a cell is O(1) and picking the
+// k-th free cell costs O(log tiles) plus a scan of 64 counts, independent
+// of the board area. A little over 1/8 byte per cell. The interior is
+// everything inside a border margin cells wide; wall cells added inside
+// it stay occupied through clear().
+class OccupancyGrid {
+private:
+    int rows;
+    int cols;
+    int margin;
+    int tileCols;                          // tiles per row of tiles
+    int tileCount;
+    int fenwickTop;                        // largest power of two <= tileCount
+    int freeCount;
+    std::vector<uint64_t> bits;            // set bit = cell covered by the snake
+    std::vector<uint64_t> columnMasks;     // interior columns of each tile column
+    std::vector<uint8_t> wordFree;         // free interior cells per word of bits
+    std::vector<uint16_t> tileFree;        // free interior cells per tile
+    std::vector<int32_t> fenwick;          // 1-based prefix sums of tileFree
+    std::vector<uint64_t> walls;           // same layout as bits; empty without walls
+
+    int tileOf(Position pos) const {
+        return (pos.row >> 6) * tileCols + (pos.col >> 6);
+    }
+
+    size_t wordOf(Position pos) const {
+        return ((size_t)tileOf(pos) << 6) | (pos.row & 63);
+    }
+
+    void adjustFree(int tile, int delta);
+
+public:
+    OccupancyGrid(int r, int c, int borderMargin = 1);
+
+    bool isOccupied(Position pos) const {
+        return (bits[wordOf(pos)] >> (pos.col & 63)) & 1;
+    }
+
+    bool isInterior(Position pos) const {
+        return pos.row >= margin && pos.row < rows - margin &&
+               pos.col >= margin && pos.col < cols - margin;
+    }
+
+    void occupy(Position pos);
+    void release(Position pos);
+
+    // Occupy a cell for good: clear() leaves it occupied
+    void addWall(Position pos);
+
+    bool isWall(Position pos) const {
+        return !walls.empty() && ((walls[wordOf(pos)] >> (pos.col & 63)) & 1);
+    }
+
+    // Mark every cell but the walls free again
+    void clear();
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+
+    int getFreeCount() const {
+        return freeCount;
+    }
+
+    // The i-th free interior cell, counting tile by tile
+    Position getFreeCell(int i) const;
+
+    size_t getMemoryUsage() const;
+};
+
+// Direction along a fixed Hamiltonian cycle of the interior: rows are
+// walked as a boustrophedon and column 1 is the return lane. Needs an even
+// number of rows; a snake laid along the cycle can follow it forever.
+Direction cycleDirection(Position pos, int rows, int cols);
+
+// What a board cell shows; the renderer maps these to glyphs
+enum CellKind {
+    CELL_EMPTY,
+    CELL_HEAD,
+    CELL_BODY,
+    CELL_FOOD,
+    CELL_WALL       // inside the border; obstacle boards only
+};
+
+// A single cell whose contents changed during a tick
+struct CellChange {
+    Position pos;
+    CellKind kind;
+};
+
+// Cell changes emitted by the simulation since the last frame. Storage is
+// fixed at construction; if a frame is not drawn for long enough to fill
+// it, the list is marked overflowed and the renderer repaints instead.
+class CellChangeList {
+private:
+    std::vector<CellChange> changes;
+    int count;
+    bool overflowed;
+
+public:
+    CellChangeList(int capacity = 64)
+        : changes(capacity), count(0), overflowed(false) {}
+
+    void add(Position pos, CellKind kind) {
+        if (count == (int)changes.size()) {
+            overflowed = true;
+            return;
+        }
+        changes[count].pos = pos;
+        changes[count].kind = kind;
+        count++;
+    }
+
+    void clear() {
+        count = 0;
+        overflowed = false;
+    }
+
+    // Force a full repaint on the next frame
+    void invalidate() {
+        count = 0;
+        overflowed = true;
+    }
+
+    int size() const { return count; }
+    bool hasOverflowed() const { return overflowed; }
+    const CellChange& operator[](int i) const { return changes[i]; }
+};
+
+// Food class
+class Food {
+private:
+    Position position;
+    char symbol;
+
+public:
+    Food() : symbol('O') {}
+
+    Food(Position pos) : position(pos), symbol('O') {}
+
+    Position getPosition() const {
+        return position;
+    }
+
+    void setPosition(Position pos) {
+        position = pos;
+    }
+
+    char getSymbol() const {
+        return symbol;
+    }
+};
+
+// The snake body is stored as a trail of 2-bit directions, four to a
+// byte: entry k is the direction segment k was entered from segment k+1,
+// so walking from the head against those directions visits the body.
+
+// Read-only view of the snake body, head first, decoded from the trail
+template <typename Topology>
+class BasicBodyView {
+private:
+    const uint8_t* trail;
+    int capacity;
+    int start;
+    int count;
+    Position head;
+    int rows;
+    int cols;
+
+public:
+    class iterator {
+    private:
+        const uint8_t* trail;
+        int capacity;
+        int slot;
+        int offset;
+        Position pos;
+        int rows;
+        int cols;
+
+    public:
+        iterator(const uint8_t* t, int cap, int s, int off, Position p, int r, int c)
+            : trail(t), capacity(cap), slot(s), offset(off), pos(p), rows(r), cols(c) {}
+
+        const Position& operator*() const { return pos; }
+
+        iterator& operator++() {
+            Direction dir = (Direction)((trail[slot >> 2] >> ((slot & 3) * 2)) & 3);
+            pos = Topology::step(pos, opposite(dir), rows, cols);
+            if (++slot == capacity) slot = 0;
+            offset++;
+            return *this;
+        }
+
+        bool operator!=(const iterator& other) const { return offset != other.offset; }
+    };
+
+    BasicBodyView(const uint8_t* t, int cap, int first, int n, Position h, int r, int c)
+        : trail(t), capacity(cap), start(first), count(n), head(h), rows(r), cols(c) {}
+
+    iterator begin() const { return iterator(trail, capacity, start, 0, head, rows, cols); }
+    iterator end() const { return iterator(trail, capacity, start, count, head, rows, cols); }
+    int size() const { return count; }
+};
+
+// Snake class, moving by the rules of the board's topology
+template <typename Topology>
+class BasicSnake {
+private:
+    // Body lives in a ring of 2-bit directions sized to the board, with
+    // the head and tail kept as positions, so move() and grow() never
+    // allocate and the body costs a quarter byte per board cell
+    std::vector<uint8_t> trail;
+    int capacity;
+    int rows;
+    int cols;
+    int headIndex;
+    int length;
+    Position head;
+    Position tail;
+    Direction direction;
+    bool growing;
+    bool selfCollided;
+    uint64_t hash;      // Zobrist hash of body, head, tail and motion
+    OccupancyGrid* grid;
+    CellChangeList* changes;
+    char headSymbol;
+    char bodySymbol;
+
+    Direction trailAt(int slot) const {
+        return (Direction)((trail[slot >> 2] >> ((slot & 3) * 2)) & 3);
+    }
+
+    void setTrail(int slot, Direction dir) {
+        int shift = (slot & 3) * 2;
+        trail[slot >> 2] = (trail[slot >> 2] & ~(3 << shift)) | (dir << shift);
+    }
+
+    uint64_t motionKey() const {
+        return zobristKey(ZOBRIST_MOTION, Position(direction, growing));
+    }
+
+    // Hash from scratch, for when the whole body is replaced
+    void rehash();
+
+public:
+    BasicSnake(Position startPos, OccupancyGrid* occupancy, CellChangeList* changeList,
+               int capacity, int initialLength = 3);
+
+    // Lay the snake out again as the constructor does, reusing the trail;
+    // the caller clears the occupancy grid first
+    void reset(Position startPos, int initialLength = 3);
+
+    Position getHead() const {
+        return head;
+    }
+
+    Position getTail() const {
+        return tail;
+    }
+
+    BasicBodyView<Topology> getBody() const {
+        return BasicBodyView<Topology>(trail.data(), capacity, headIndex, length, head, rows, cols);
+    }
+
+    int getLength() const {
+        return length;
+    }
+
+    Direction getDirection() const {
+        return direction;
+    }
+
+    void setDirection(Direction newDir);
+
+    // One tick of movement: the tail leaves (unless growing), then the
+    // head lands. Boards where several snakes move at once call the halves
+    // separately so every tail is gone before any head lands.
+    void move() {
+        vacateTail();
+        advanceHead();
+    }
+    void vacateTail();
+    void advanceHead();
+
+    void grow() {
+        hash ^= motionKey();
+        growing = true;
+        hash ^= motionKey();
+    }
+
+    bool isGrowing() const {
+        return growing;
+    }
+
+    // Point a copied snake at its own board's grid and change list
+    void rebind(OccupancyGrid* occupancy, CellChangeList* changeList) {
+        grid = occupancy;
+        changes = changeList;
+    }
+
+    // Replace the body (head first, each cell next to the one before) and
+    // movement state; the caller is responsible for the occupancy grid
+    void restore(const Position* cells, int count, Direction dir, bool grow, bool collided);
+
+    // True once the head has landed on an occupied cell: the body, or a
+    // wall on an obstacle board
+    bool checkSelfCollision() const {
+        return selfCollided;
+    }
+
+    // Zobrist hash, kept up to date by move(), grow() and setDirection()
+    uint64_t getHash() const {
+        return hash;
+    }
+
+    char getHeadSymbol() const { return headSymbol; }
+    char getBodySymbol() const { return bodySymbol; }
+
+    size_t getMemoryUsage() const {
+        return trail.capacity();
+    }
+};
+
+// Smallest board a game can start on. The snake starts three cells long
+// with its head on the centre column, so its tail is at cols / 2 - 2 and
+// needs six columns to stay off the left border.
+const int MIN_BOARD_ROWS = 4;
+const int MIN_BOARD_COLS = 6;
+
+// GameBoard class: the simulation state of one game. The board owns all
+// of its state by value; every buffer is sized to the board when it is
+// built, so stepping and reset() never allocate. Topology is one of the
+// policies above; GameBoard, TorusBoard and ObstacleBoard below name the
+// three instantiations, all compiled in snake_engine.cpp.
+template <typename Topology>
+class BasicGameBoard {
+public:
+    typedef BasicSnake<Topology> SnakeType;
+
+private:
+    int rows;
+    int cols;
+    OccupancyGrid grid;
+    CellChangeList changes;
+    SnakeType snake;    // points at grid and changes above
+    Food food;
+    Rng rng;
+    int score;
+    int highScore;
+    bool gameOver;
+
+public:
+    BasicGameBoard(int r = 20, int c = 40, uint64_t seed = 0);
+
+    // Boards copy deeply. Assigning between boards of the same size reuses
+    // the destination's buffers, so a planner can reset a scratch board to
+    // the root state for every rollout without touching the heap.
+    BasicGameBoard(const BasicGameBoard& other);
+    BasicGameBoard& operator=(const BasicGameBoard& other);
+
+    // Start a new game in the same buffers: length 3 in the middle,
+    // heading right. The high score carries over.
+    void reset(uint64_t seed);
+
+    // Carry over a high score kept elsewhere, e.g. a saved leaderboard
+    void setHighScore(int value) {
+        highScore = value;
+    }
+
+    // Reseed the food RNG, e.g. so rollouts do not foresee real spawns
+    void reseed(uint64_t seed) {
+        rng.reseed(seed);
+    }
+
+    // Apply an action and advance one tick
+    StepResult step(Action action);
+
+    // Put the food on a random free cell; with none left it is removed
+    void spawnFood();
+
+    // Replace the snake with the given body (head first) heading in dir,
+    // moving the food if it ends up underneath. For setting up bots and
+    // benchmarks at a given length.
+    void placeSnake(const Position* body, int count, Direction dir);
+
+    // Make a cell a wall for this and every later game. Fails on other
+    // topologies, on the border, and under the snake or where it starts.
+    bool addWall(Position pos);
+
+    // Append a snapshot of the full simulation state (including the RNG)
+    // to out; loadState() restores it exactly. A snapshot for another board
+    // size, or one whose snake or food could not be on this board, is
+    // refused with false and the board is left as it was.
+    void saveState(std::vector<uint8_t>& out) const;
+    bool loadState(const uint8_t* data, size_t size);
+
+    bool checkCollision();
+    bool checkFoodCollision();
+    void update();
+    bool didEatFood();
+
+    // What the given cell currently shows
+    CellKind cellAt(Position pos) const {
+        if (Topology::HAS_OBSTACLES && grid.isWall(pos)) return CELL_WALL;
+        if (pos == snake.getHead()) return CELL_HEAD;
+        if (grid.isOccupied(pos)) return CELL_BODY;
+        if (pos == food.getPosition()) return CELL_FOOD;
+        return CELL_EMPTY;
+    }
+
+    // Shorthands shared with BitboardBoard so policies can be written once
+    // for either engine
+    Position getHead() const { return snake.getHead(); }
+    Position getTail() const { return snake.getTail(); }
+    Position getFoodPosition() const { return food.getPosition(); }
+    bool isOccupied(Position pos) const { return grid.isOccupied(pos); }
+    static const char* engineName() { return Topology::engineName(); }
+
+    // Zobrist hash of the position: the snake's, which is updated
+    // incrementally every tick, plus the food's key
+    uint64_t getHash() const {
+        return snake.getHash() ^ zobristKey(ZOBRIST_FOOD, food.getPosition());
+    }
+
+    // Heap bytes held by the board's per-cell structures
+    size_t getMemoryUsage() const {
+        return grid.getMemoryUsage() + snake.getMemoryUsage();
+    }
+
+    SnakeType* getSnake() { return &snake; }
+    const SnakeType* getSnake() const { return &snake; }
+    const Food* getFood() const { return &food; }
+    const OccupancyGrid& getGrid() const { return grid; }
+    CellChangeList& getChanges() { return changes; }
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    bool isGameOver() const { return gameOver; }
+    int getScore() const { return score; }
+    int getHighScore() const { return highScore; }
+    int getSnakeLength() const { return snake.getLength(); }
+};
+
+typedef BasicSnake<BoundedTopology> Snake;
+typedef BasicGameBoard<BoundedTopology> GameBoard;      // walls all round
+typedef BasicGameBoard<TorusTopology> TorusBoard;       // wraps at the edges
+typedef BasicGameBoard<ObstacleTopology> ObstacleBoard; // walls inside too
+
+#endif
@@ -0,0 +1,223 @@
+#include "snake_env.h"
+
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "snake_engine.h"
+
+using namespace std;
+
+// The handle behind the C API. The topology is fixed at creation, so the
+// per-board work lives in BoardEnv<Board> and a step makes one virtual
+// call for the whole batch.
+struct SnakeEnv {
+    int count;
+    int rows;
+    int cols;
+    size_t area;                 // cells per plane
+    uint64_t seed;
+    vector<uint8_t> ownedPlanes; // empty when the caller passed a buffer
+    uint8_t* planes;
+
+    SnakeEnv(int n, int r, int c, uint8_t* buffer)
+        : count(n), rows(r), cols(c), area((size_t)r * c), seed(0), planes(buffer) {
+        if (!planes) {
+            ownedPlanes.resize(snake_env_planes_size(n, r, c));
+            planes = ownedPlanes.data();
+        }
+    }
+
+    virtual ~SnakeEnv() {}
+
+    uint8_t* planesOf(int i) {
+        return planes + (size_t)i * SNAKE_PLANES * area;
+    }
+
+    // Seed of board i's game number episode: depends on nothing else, so
+    // board i plays the same games in any batch size
+    uint64_t seedFor(int i, uint64_t episode) const {
+        return splitmix64(splitmix64(seed + i) + episode);
+    }
+
+    virtual void reset(uint64_t newSeed) = 0;
+    virtual void step(const uint8_t* actions, float* rewards, uint8_t* dones) = 0;
+    virtual bool addWall(Position pos) = 0;
+    virtual void getScores(int32_t* scores, int32_t* lengths) const = 0;
+};
+
+namespace {
+
+template <typename Board>
+class BoardEnv : public SnakeEnv {
+private:
+    vector<Board> boards;
+    vector<uint64_t> episodes;   // games each board has finished
+
+    // Bring board i's head, body and food planes up to date with the
+    // cells it changed since the last call. Each change names what the
+    // cell holds now, so it is three stores; after a reset or an
+    // overflow the planes are cleared and the snake and food drawn again.
+    void applyChanges(int i) {
+        Board& board = boards[i];
+        CellChangeList& changes = board.getChanges();
+        uint8_t* head = planesOf(i) + SNAKE_PLANE_HEAD * area;
+        uint8_t* body = planesOf(i) + SNAKE_PLANE_BODY * area;
+        uint8_t* food = planesOf(i) + SNAKE_PLANE_FOOD * area;
+
+        if (changes.hasOverflowed()) {
+            memset(head, 0, 3 * area);
+            for (const Position& pos : board.getSnake()->getBody()) {
+                body[(size_t)pos.row * cols + pos.col] = 1;
+            }
+            Position h = board.getHead();
+            head[(size_t)h.row * cols + h.col] = 1;
+            body[(size_t)h.row * cols + h.col] = 0;
+            Position f = board.getFoodPosition();
+            if (f.row >= 0) food[(size_t)f.row * cols + f.col] = 1;
+        } else {
+            for (int k = 0; k < changes.size(); k++) {
+                const CellChange& change = changes[k];
+                size_t cell = (size_t)change.pos.row * cols + change.pos.col;
+                head[cell] = change.kind == CELL_HEAD;
+                body[cell] = change.kind == CELL_BODY;
+                food[cell] = change.kind == CELL_FOOD;
+            }
+        }
+        changes.clear();
+    }
+
+    // The wall plane is the same on every board: draw it on the first and
+    // copy it to the rest
+    void drawWalls() {
+        uint8_t* walls = planesOf(0) + SNAKE_PLANE_WALL * area;
+        bool bordered = !is_same<Board, TorusBoard>::value;
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                bool border = r == 0 || r == rows - 1 || c == 0 || c == cols - 1;
+                walls[(size_t)r * cols + c] =
+                    (bordered && border) || boards[0].cellAt(Position(r, c)) == CELL_WALL;
+            }
+        }
+        for (int i = 1; i < count; i++) {
+            memcpy(planesOf(i) + SNAKE_PLANE_WALL * area, walls, area);
+        }
+    }
+
+public:
+    BoardEnv(int n, int r, int c, uint64_t firstSeed, uint8_t* buffer)
+        : SnakeEnv(n, r, c, buffer), episodes(n, 0) {
+        boards.reserve(n);
+        for (int i = 0; i < n; i++) {
+            boards.emplace_back(r, c);
+        }
+        drawWalls();
+        reset(firstSeed);
+    }
+
+    void reset(uint64_t newSeed) override {
+        seed = newSeed;
+        for (int i = 0; i < count; i++) {
+            episodes[i] = 0;
+            boards[i].reset(seedFor(i, 0));
+            applyChanges(i);
+        }
+    }
+
+    void step(const uint8_t* actions, float* rewards, uint8_t* dones) override {
+        for (int i = 0; i < count; i++) {
+            Board& board = boards[i];
+            StepResult result = board.step((Action)actions[i]);
+            float reward = result.ateFood ? 1.0f : 0.0f;
+            if (result.gameOver) {
+                reward = -1.0f;
+                board.reset(seedFor(i, ++episodes[i]));
+            }
+            applyChanges(i);
+            if (rewards) rewards[i] = reward;
+            if (dones) dones[i] = result.gameOver;
+        }
+    }
+
+    bool addWall(Position pos) override {
+        // Fresh games first, so no snake is in the way, then the wall,
+        // then fresh games again so food is placed knowing the wall
+        for (int i = 0; i < count; i++) {
+            boards[i].reset(seedFor(i, 0));
+            if (!boards[i].addWall(pos)) {
+                reset(seed);
+                return false;
+            }
+        }
+        drawWalls();
+        reset(seed);
+        return true;
+    }
+
+    void getScores(int32_t* scores, int32_t* lengths) const override {
+        for (int i = 0; i < count; i++) {
+            if (scores) scores[i] = boards[i].getScore();
+            if (lengths) lengths[i] = boards[i].getSnakeLength();
+        }
+    }
+};
+
+}  // namespace
+
+size_t snake_env_planes_size(int envs, int rows, int cols) {
+    return (size_t)envs * SNAKE_PLANES * rows * cols;
+}
+
+SnakeEnv* snake_env_create(int envs, int rows, int cols, int topology, uint64_t seed,
+                           uint8_t* planes) {
+    if (envs < 1 || rows < MIN_BOARD_ROWS || cols < MIN_BOARD_COLS || rows > 32766 ||
+        cols > 32766) {
+        return NULL;
+    }
+    switch (topology) {
+        case SNAKE_TOPOLOGY_BOUNDED:
+            // Obstacle boards play exactly like GameBoard until a wall is added
+            return new BoardEnv<ObstacleBoard>(envs, rows, cols, seed, planes);
+        case SNAKE_TOPOLOGY_TORUS:
+            return new BoardEnv<TorusBoard>(envs, rows, cols, seed, planes);
+        default:
+            return NULL;
+    }
+}
+
+void snake_env_destroy(SnakeEnv* env) {
+    delete env;
+}
+
+void snake_env_reset(SnakeEnv* env, uint64_t seed) {
+    env->reset(seed);
+}
+
+void snake_env_step(SnakeEnv* env, const uint8_t* actions, float* rewards, uint8_t* dones) {
+    env->step(actions, rewards, dones);
+}
+
+const uint8_t* snake_env_observe(const SnakeEnv* env) {
+    return env->planes;
+}
+
+int snake_env_add_wall(SnakeEnv* env, int row, int col) {
+    if (row < 0 || row >= env->rows || col < 0 || col >= env->cols) return 0;
+    return env->addWall(Position(row, col));
+}
+
+int snake_env_num_envs(const SnakeEnv* env) {
+    return env->count;
+}
+
+int snake_env_rows(const SnakeEnv* env) {
+    return env->rows;
+}
+
+int snake_env_cols(const SnakeEnv* env) {
+    return env->cols;
+}
+
+void snake_env_scores(const SnakeEnv* env, int32_t* scores, int32_t* lengths) {
+    env->getScores(scores, lengths);
+}
@@ -0,0 +1,85 @@
+/* Reinforcement-learning environment with a C ABI, for loading from Python
+ * (ctypes/cffi) or any other language as libsnake_env.so. One handle runs
+ * a batch of boards of the same size that step together; a board whose
+ * snake dies starts its next game on the same step.
+ *
+ * Observations are uint8 feature planes, 0 or 1, laid out as
+ *   planes[env][SNAKE_PLANE_*][row][col]
+ * in one contiguous buffer, so NumPy can wrap it as an (envs, 4, rows,
+ * cols) array without copying. The buffer is either passed in by the
+ * caller or owned by the handle, and step() updates it in place from each
+ * board's changed cells (a handful per tick), so a step does not redraw
+ * the board and does not allocate.
+ *
+ * Actions are the engine's Action values: 0 keep going, 1 up, 2 down,
+ * 3 left, 4 right. Rewards are +1 for food, -1 for dying and 0 otherwise.
+ */
+#ifndef SNAKE_ENV_H
+#define SNAKE_ENV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SnakeEnv SnakeEnv;
+
+/* Feature planes, in buffer order */
+enum {
+    SNAKE_PLANE_HEAD,
+    SNAKE_PLANE_BODY,     /* every segment but the head */
+    SNAKE_PLANE_FOOD,
+    SNAKE_PLANE_WALL,     /* border and obstacles; fixed between add_wall calls */
+    SNAKE_PLANES
+};
+
+enum {
+    SNAKE_TOPOLOGY_BOUNDED,   /* walled border; obstacles can be added */
+    SNAKE_TOPOLOGY_TORUS      /* no walls, the snake wraps at the edges */
+};
+
+/* Bytes of plane buffer for a batch */
+size_t snake_env_planes_size(int envs, int rows, int cols);
+
+/* Create envs boards of rows x cols and start the first games. planes is
+ * a caller buffer of snake_env_planes_size() bytes that must outlive the
+ * handle, or NULL to have the handle allocate one. Returns NULL for an
+ * unknown topology, fewer than one board or a board outside 4x6 (rows x
+ * cols) to 32766x32766. */
+SnakeEnv* snake_env_create(int envs, int rows, int cols, int topology, uint64_t seed,
+                           uint8_t* planes);
+void snake_env_destroy(SnakeEnv* env);
+
+/* Start new games on every board. Board i's games are seeded from seed
+ * and i alone, so a batch replays the same way whatever its size. */
+void snake_env_reset(SnakeEnv* env, uint64_t seed);
+
+/* Advance every board one tick. actions holds one Action per board;
+ * rewards and dones (one per board each) may be NULL. A board with
+ * dones[i] = 1 has already been reset, and its planes show the new game. */
+void snake_env_step(SnakeEnv* env, const uint8_t* actions, float* rewards, uint8_t* dones);
+
+/* The plane buffer. It stays at the same address for the life of the
+ * handle, so it only needs to be wrapped once. */
+const uint8_t* snake_env_observe(const SnakeEnv* env);
+
+/* Make a cell a wall on every board. Bounded boards only; returns 0 for
+ * the border, the start cells and other topologies. Either way every
+ * board then starts a new game, as snake_env_reset() with the last seed
+ * does. */
+int snake_env_add_wall(SnakeEnv* env, int row, int col);
+
+int snake_env_num_envs(const SnakeEnv* env);
+int snake_env_rows(const SnakeEnv* env);
+int snake_env_cols(const SnakeEnv* env);
+
+/* Score and length of each board's current game, one int32 per board */
+void snake_env_scores(const SnakeEnv* env, int32_t* scores, int32_t* lengths);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
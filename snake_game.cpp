@@ -1,495 +1,126 @@
 #include <iostream>
-#include <deque>
-#include <vector>
+#include <csignal>
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <string>
 
-// Platform-specific headers
-#ifdef _WIN32
-    #include <conio.h>
-    #include <windows.h>
-    #define SLEEP(ms) Sleep(ms)
-#else
-    #include <termios.h>
-    #include <unistd.h>
-    #include <fcntl.h>
-    #define SLEEP(ms) usleep((ms) * 1000)
-#endif
+#include "snake_autopilot.h"
+#include "snake_engine.h"
+#include "snake_planner.h"
+#include "snake_profiler.h"
+#include "snake_replay.h"
+#include "snake_scores.h"
+#include "snake_terminal.h"
 
 using namespace std;
 
-// Enum for directions
-enum Direction {
-    UP,
-    DOWN,
-    LEFT,
-    RIGHT
-};
-
-// Utility function to clear screen (only called once at start)
-void clearScreen() {
-    #ifdef _WIN32
-        system("cls");
-    #else
-        system("clear");
-    #endif
-}
-
-// Set cursor position to avoid flickering
-void setCursorPosition(int x, int y) {
-    #ifdef _WIN32
-        COORD coord;
-        coord.X = x;
-        coord.Y = y;
-        SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), coord);
-    #else
-        printf("\033[%d;%dH", y + 1, x + 1);
-        fflush(stdout);
-    #endif
-}
-
-// Hide cursor to avoid flickering
-void hideCursor() {
-    #ifdef _WIN32
-        HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
-        CONSOLE_CURSOR_INFO info;
-        info.dwSize = 100;
-        info.bVisible = FALSE;
-        SetConsoleCursorInfo(consoleHandle, &info);
-    #else
-        printf("\e[?25l");
-        fflush(stdout);
-    #endif
-}
+// Set by Ctrl+C or SIGTERM; the game notices it within a tick and exits
+// through the normal path, which restores the terminal
+static volatile sig_atomic_t quitRequested = 0;
 
-// Show cursor
-void showCursor() {
-    #ifdef _WIN32
-        HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
-        CONSOLE_CURSOR_INFO info;
-        info.dwSize = 100;
-        info.bVisible = TRUE;
-        SetConsoleCursorInfo(consoleHandle, &info);
-    #else
-        printf("\e[?25h");
-        fflush(stdout);
-    #endif
+static void onSignal(int) {
+    quitRequested = 1;
 }
 
-// Class representing a position
-class Position {
-public:
-    int row;
-    int col;
-    
-    Position(int r = 0, int c = 0) : row(r), col(c) {}
-    
-    bool operator==(const Position& other) const {
-        return row == other.row && col == other.col;
-    }
-};
-
-// Food class
-class Food {
-private:
-    Position position;
-    char symbol;
-    
-public:
-    Food() : symbol('O') {}
-    
-    Food(Position pos) : position(pos), symbol('O') {}
-    
-    Position getPosition() const {
-        return position;
-    }
-    
-    void setPosition(Position pos) {
-        position = pos;
-    }
-    
-    char getSymbol() const {
-        return symbol;
-    }
-};
-
-// Snake class
-class Snake {
-private:
-    deque<Position> body;
-    Direction direction;
-    bool growing;
-    char headSymbol;
-    char bodySymbol;
-    
-public:
-    Snake(Position startPos, int length = 3) 
-        : direction(RIGHT), growing(false), headSymbol('#'), bodySymbol('o') {
-        // Initialize snake body (horizontal line)
-        for (int i = 0; i < length; i++) {
-            body.push_back(Position(startPos.row, startPos.col - i));
-        }
-    }
-    
-    Position getHead() const {
-        return body.front();
-    }
-    
-    deque<Position> getBody() const {
-        return body;
-    }
-    
-    Direction getDirection() const {
-        return direction;
-    }
-    
-    void setDirection(Direction newDir) {
-        // Prevent moving in opposite direction
-        if ((direction == UP && newDir == DOWN) ||
-            (direction == DOWN && newDir == UP) ||
-            (direction == LEFT && newDir == RIGHT) ||
-            (direction == RIGHT && newDir == LEFT)) {
-            return;
-        }
-        direction = newDir;
-    }
-    
-    void move() {
-        Position head = getHead();
-        Position newHead = head;
-        
-        // Calculate new head position based on direction
-        switch (direction) {
-            case UP:    newHead.row--; break;
-            case DOWN:  newHead.row++; break;
-            case LEFT:  newHead.col--; break;
-            case RIGHT: newHead.col++; break;
-        }
-        
-        body.push_front(newHead);
-        
-        if (!growing) {
-            body.pop_back();
-        } else {
-            growing = false;
-        }
-    }
-    
-    void grow() {
-        growing = true;
-    }
-    
-    bool checkSelfCollision() const {
-        Position head = getHead();
-        for (size_t i = 1; i < body.size(); i++) {
-            if (body[i] == head) {
-                return true;
-            }
-        }
-        return false;
-    }
-    
-    char getHeadSymbol() const { return headSymbol; }
-    char getBodySymbol() const { return bodySymbol; }
-};
-
-// GameBoard class
-class GameBoard {
+// Game class
+class Game {
 private:
-    int rows;
-    int cols;
-    Snake* snake;
-    Food* food;
-    int score;
-    int highScore;
-    bool gameOver;
-    vector<vector<char>> previousBoard;
-    
-    void spawnFood() {
-        // Get snake positions
-        deque<Position> snakeBody = snake->getBody();
-        vector<Position> availablePositions;
-        
-        // Find available positions
-        for (int r = 1; r < rows - 1; r++) {
-            for (int c = 1; c < cols - 1; c++) {
-                Position pos(r, c);
-                bool occupied = false;
-                
-                for (const Position& bodyPart : snakeBody) {
-                    if (bodyPart == pos) {
-                        occupied = true;
-                        break;
-                    }
-                }
-                
-                if (!occupied) {
-                    availablePositions.push_back(pos);
-                }
-            }
-        }
-        
-        if (!availablePositions.empty()) {
-            int randomIndex = rand() % availablePositions.size();
-            food->setPosition(availablePositions[randomIndex]);
-        }
-    }
+    GameBoard* board;
+    BoardRenderer* renderer;
+    RenderThread* renderThread;  // draws on its own thread if set
+    InputHandler* inputHandler;
+    TickScheduler* scheduler;
+    ReplayRecorder* recorder;
+    ReplayPlayer* player;
+    Autopilot* autopilot;
+    MctsPlanner* planner;  // steers instead of the autopilot if set
+    ScoreStore* scores;  // persistent leaderboard, if one could be opened
+    FrameProfiler profiler;
+    bool profileOverlay; // show the profiler's status line
+    string tracePath;    // write a Chrome trace here on exit if set
+    bool autopilotOn;    // the autopilot steers instead of the keys
+    bool running;
+    bool threadedRender; // draw frames on a render thread
+    int speed;           // milliseconds per simulation tick
+    int renderInterval;  // milliseconds per rendered frame
+    int boardRows;
+    int boardCols;
+    string recordPath;   // record each game here (FILE, FILE.2, ...) if set
+    string recordStatus;
+    string savePath;     // recordPath plus the game number, reused
+    int gamesPlayed;
+    string playerName;   // name finished games are recorded under
+    string scoresStatus; // why there is no leaderboard, if there is none
+    int lastRank;        // leaderboard rank of the game just finished, 0 if none
+    uint32_t gameTicks;
     
 public:
-    GameBoard(int r = 20, int c = 40) 
-        : rows(r), cols(c), score(0), highScore(0), gameOver(false) {
-        srand(time(0));
-        snake = new Snake(Position(rows / 2, cols / 2));
-        food = new Food();
-        previousBoard = vector<vector<char>>(rows, vector<char>(cols, ' '));
-        spawnFood();
+    Game(int tickMs = 100, int renderMs = 100, int rows = 20, int cols = 40)
+        : board(NULL), renderer(NULL), renderThread(NULL), scheduler(NULL), recorder(NULL), player(NULL),
+          autopilot(NULL), planner(NULL), scores(NULL), profileOverlay(false), autopilotOn(false), running(true), threadedRender(false), speed(tickMs), renderInterval(renderMs),
+          boardRows(rows), boardCols(cols), gamesPlayed(0), playerName("player"), lastRank(0),
+          gameTicks(0) {
+        inputHandler = new InputHandler();
     }
     
-    ~GameBoard() {
-        delete snake;
-        delete food;
+    ~Game() {
+        if (board) delete board;
+        if (renderThread) delete renderThread;
+        if (renderer) delete renderer;
+        if (scheduler) delete scheduler;
+        if (recorder) delete recorder;
+        if (player) delete player;
+        if (autopilot) delete autopilot;
+        if (planner) delete planner;
+        if (scores) delete scores;  // syncs the log before exiting
+        delete inputHandler;
+        showCursor();
     }
     
-    bool checkCollision() {
-        Position head = snake->getHead();
-        
-        // Boundary collision
-        if (head.row <= 0 || head.row >= rows - 1 ||
-            head.col <= 0 || head.col >= cols - 1) {
-            return true;
-        }
-        
-        // Self collision
-        if (snake->checkSelfCollision()) {
-            return true;
-        }
-        
-        return false;
+    void setRecordPath(const string& path) {
+        recordPath = path;
     }
     
-    bool checkFoodCollision() {
-        if (snake->getHead() == food->getPosition()) {
-            snake->grow();
-            score += 10;
-            spawnFood();
-            return true;  // Food was eaten
-        }
-        return false;
+    // Time every phase of the loop; overlay shows the stats while playing
+    // and a trace path saves them for chrome://tracing or Perfetto
+    void enableProfiler(bool overlay, const string& path) {
+        profileOverlay = overlay;
+        tracePath = path;
+        profiler.enable(path.empty() ? 0 : 1 << 18);
     }
     
-    void update() {
-        if (!gameOver) {
-            snake->move();
-            
-            if (checkCollision()) {
-                gameOver = true;
-                if (score > highScore) {
-                    highScore = score;
-                }
-            } else {
-                checkFoodCollision();
-            }
-        }
+    // Draw on a separate thread so slow terminal output cannot hold up
+    // ticks or input
+    void setThreadedRender(bool on) {
+        threadedRender = on;
     }
     
-    bool didEatFood() {
-        // Check if food was just eaten
-        if (!gameOver) {
-            return checkFoodCollision();
-        }
-        return false;
+    void setAutopilot(bool on) {
+        autopilotOn = on;
     }
     
-    void renderInitial() {
-        // First time render - draw everything
-        clearScreen();
-        hideCursor();
-        
-        // Create board
-        vector<vector<char>> board(rows, vector<char>(cols, ' '));
-        
-        // Draw boundaries
-        for (int i = 0; i < cols; i++) {
-            board[0][i] = '=';
-            board[rows - 1][i] = '=';
-        }
-        for (int i = 0; i < rows; i++) {
-            board[i][0] = '|';
-            board[i][cols - 1] = '|';
-        }
-        board[0][0] = '+';
-        board[0][cols - 1] = '+';
-        board[rows - 1][0] = '+';
-        board[rows - 1][cols - 1] = '+';
-        
-        // Print board
-        for (int r = 0; r < rows; r++) {
-            for (int c = 0; c < cols; c++) {
-                cout << board[r][c];
-            }
-            cout << endl;
-        }
-        
-        cout << "\nScore: 0  |  High Score: 0  |  Length: 3" << endl;
-        cout << "Controls: W/A/S/D or Arrow Keys  |  Q: Quit" << endl;
-        
-        previousBoard = board;
+    // Let the MCTS planner steer, searching for half of every tick
+    void useMcts() {
+        planner = new MctsPlanner(boardRows, boardCols, 0, time(0));
     }
     
-    void render() {
-        // Create current board state - start fresh from boundaries
-        vector<vector<char>> board(rows, vector<char>(cols, ' '));
-        
-        // Draw boundaries
-        for (int i = 0; i < cols; i++) {
-            board[0][i] = '=';
-            board[rows - 1][i] = '=';
-        }
-        for (int i = 0; i < rows; i++) {
-            board[i][0] = '|';
-            board[i][cols - 1] = '|';
-        }
-        board[0][0] = '+';
-        board[0][cols - 1] = '+';
-        board[rows - 1][0] = '+';
-        board[rows - 1][cols - 1] = '+';
-        
-        // Draw food
-        Position foodPos = food->getPosition();
-        board[foodPos.row][foodPos.col] = food->getSymbol();
-        
-        // Draw snake
-        deque<Position> snakeBody = snake->getBody();
-        for (size_t i = 0; i < snakeBody.size(); i++) {
-            Position pos = snakeBody[i];
-            if (i == 0) {
-                board[pos.row][pos.col] = snake->getHeadSymbol();
-            } else {
-                board[pos.row][pos.col] = snake->getBodySymbol();
-            }
-        }
-        
-        // Only update changed positions
-        for (int r = 1; r < rows - 1; r++) {
-            for (int c = 1; c < cols - 1; c++) {
-                if (board[r][c] != previousBoard[r][c]) {
-                    setCursorPosition(c, r);
-                    cout << board[r][c];
-                    cout.flush();
-                }
-            }
+    // Keep a leaderboard across sessions in the store at path. Without
+    // one the high score only lasts until the program exits.
+    void openScores(const string& path, const string& name) {
+        scores = new ScoreStore();
+        if (!scores->open(path.c_str())) {
+            scoresStatus = scores->getError();
+            delete scores;
+            scores = NULL;
         }
-        
-        // Update score display
-        setCursorPosition(0, rows);
-        cout << "Score: " << score << "  |  High Score: " << highScore 
-             << "  |  Length: " << snakeBody.size() << "   ";
-        cout.flush();
-        
-        previousBoard = board;
+        if (!name.empty()) playerName = name;
     }
     
-    Snake* getSnake() { return snake; }
-    bool isGameOver() const { return gameOver; }
-    int getScore() const { return score; }
-    int getHighScore() const { return highScore; }
-    int getSnakeLength() const { return snake->getBody().size(); }
-};
-
-// InputHandler class
-class InputHandler {
-private:
-    #ifndef _WIN32
-        struct termios oldSettings;
-    #endif
-    
-public:
-    InputHandler() {
-        #ifndef _WIN32
-            tcgetattr(STDIN_FILENO, &oldSettings);
-        #endif
-    }
-    
-    ~InputHandler() {
-        cleanup();
-    }
-    
-    char getKey() {
-        #ifdef _WIN32
-            if (_kbhit()) {
-                char key = _getch();
-                if (key == -32 || key == 0) {  // Arrow key prefix
-                    key = _getch();
-                    switch (key) {
-                        case 72: return 'U';  // UP
-                        case 80: return 'D';  // DOWN
-                        case 75: return 'L';  // LEFT
-                        case 77: return 'R';  // RIGHT
-                    }
-                }
-                return toupper(key);
-            }
-            return '\0';
-        #else
-            struct termios newSettings;
-            tcgetattr(STDIN_FILENO, &newSettings);
-            newSettings.c_lflag &= ~(ICANON | ECHO);
-            tcsetattr(STDIN_FILENO, TCSANOW, &newSettings);
-            
-            int oldf = fcntl(STDIN_FILENO, F_GETFL, 0);
-            fcntl(STDIN_FILENO, F_SETFL, oldf | O_NONBLOCK);
-            
-            char ch = '\0';
-            if (read(STDIN_FILENO, &ch, 1) > 0) {
-                if (ch == 27) {  // Escape sequence
-                    char seq[2];
-                    if (read(STDIN_FILENO, &seq[0], 1) > 0 && 
-                        read(STDIN_FILENO, &seq[1], 1) > 0) {
-                        if (seq[0] == '[') {
-                            switch (seq[1]) {
-                                case 'A': return 'U';  // UP
-                                case 'B': return 'D';  // DOWN
-                                case 'D': return 'L';  // LEFT
-                                case 'C': return 'R';  // RIGHT
-                            }
-                        }
-                    }
-                }
-                ch = toupper(ch);
-            }
-            
-            tcsetattr(STDIN_FILENO, TCSANOW, &oldSettings);
-            fcntl(STDIN_FILENO, F_SETFL, oldf);
-            
-            return ch;
-        #endif
-    }
-    
-    void cleanup() {
-        #ifndef _WIN32
-            tcsetattr(STDIN_FILENO, TCSANOW, &oldSettings);
-        #endif
-    }
-};
-
-// Game class
-class Game {
-private:
-    GameBoard* board;
-    InputHandler* inputHandler;
-    bool running;
-    int speed;  // milliseconds per frame
-    
-public:
-    Game() : board(NULL), running(true), speed(100) {
-        inputHandler = new InputHandler();
-    }
-    
-    ~Game() {
-        if (board) delete board;
-        delete inputHandler;
-        showCursor();
+    // Play a recorded game instead of reading the keyboard
+    bool openReplay(const string& path) {
+        player = new ReplayPlayer();
+        return player->open(path.c_str());
     }
     
     void showMenu() {
@@ -502,15 +133,77 @@ public:
         cout << "    A or LEFT  : Move Left" << endl;
         cout << "    S or DOWN  : Move Down" << endl;
         cout << "    D or RIGHT : Move Right" << endl;
+        cout << "    P          : Toggle Autopilot" << endl;
         cout << "    Q          : Quit Game" << endl;
         cout << "\n  Objective:" << endl;
         cout << "    * Eat food (O) to grow and score points" << endl;
         cout << "    * Avoid hitting walls and yourself" << endl;
         cout << "    * Try to beat your high score!" << endl;
         cout << "\n-----------------------------------------" << endl;
-        cout << "\n  Press ENTER to start...";
-        cin.ignore();
-        cin.get();
+        cout << "\n  Press ENTER to start..." << flush;
+        
+        char key;
+        do {
+            key = inputHandler->waitForKey();
+        } while (key != '\n' && key != '\r' && key != 'Q' && !quitRequested);
+        if (key == 'Q' || quitRequested) {
+            running = false;
+        }
+    }
+    
+    // Turn one queued key into this tick's action; false if it would have
+    // no effect so the next queued key can be tried in the same tick
+    bool applyKey(char key, Action& action) {
+        Direction current = board->getSnake()->getDirection();
+        Direction wanted;
+        
+        if (key == 'W' || key == KEY_UP) {
+            wanted = UP;
+        } else if (key == 'S' || key == KEY_DOWN) {
+            wanted = DOWN;
+        } else if (key == 'A' || key == KEY_LEFT) {
+            wanted = LEFT;
+        } else if (key == 'D' || key == KEY_RIGHT) {
+            wanted = RIGHT;
+        } else if (key == 'Q') {
+            running = false;
+            return true;
+        } else if (key == 'P' && !player) {
+            autopilotOn = !autopilotOn;
+            return false;
+        } else {
+            return false;
+        }
+        
+        // Same heading or a reversal: nothing to record
+        if (wanted == current || wanted == (current ^ 1)) {
+            return false;
+        }
+        action = (Action)(ACTION_UP + wanted);
+        return true;
+    }
+    
+    // Write out the game just finished, if recording
+    void saveRecording() {
+        if (!recorder) return;
+        
+        // The strings keep their capacity from game to game
+        savePath.assign(recordPath);
+        if (gamesPlayed > 1) {
+            savePath += '.';
+            savePath += to_string(gamesPlayed);
+        }
+        recordStatus.assign(recorder->save(savePath.c_str()) ? "saved to " : "could not write ");
+        recordStatus += savePath;
+    }
+    
+    // Add the game just finished to the leaderboard. This only appends
+    // to the log; the fsync happens on the store's own thread.
+    void saveScore() {
+        lastRank = 0;
+        if (!scores || player || !board->isGameOver()) return;
+        lastRank = scores->record(playerName.c_str(), board->getScore(),
+                                  board->getSnakeLength(), gameTicks);
     }
     
     bool showGameOver() {
@@ -522,57 +215,177 @@ public:
         cout << "\n  Final Score: " << board->getScore() << endl;
         cout << "  High Score:  " << board->getHighScore() << endl;
         cout << "  Snake Length: " << board->getSnakeLength() << endl;
+        if (scores) {
+            vector<ScoreRecord> top = scores->getTop(5);
+            cout << "\n  Leaderboard (" << scores->getGames() << " games):" << endl;
+            for (size_t i = 0; i < top.size(); i++) {
+                printf("    %zu. %-15s %6d\n", i + 1, top[i].name, top[i].score);
+            }
+            if (lastRank > 5) {
+                printf("    %d. %-15s %6d\n", lastRank, playerName.c_str(), board->getScore());
+            }
+            cout << endl;
+        } else if (!scoresStatus.empty()) {
+            cout << "  Leaderboard off: " << scoresStatus << endl;
+        }
+        const FrameComposer& composer = renderThread ? renderThread->getComposer()
+                                                     : renderer->getComposer();
+        printf("  Output: %.1f bytes, %.2f writes per frame\n",
+               composer.getAverageBytes(), composer.getAverageWrites());
+        long long skipped = renderThread ? renderThread->getSkipped() : renderer->getSkippedFrames();
+        if (skipped > 0) {
+            printf("  Terminal backlog: %lld frames skipped, drains at %.0f bytes/s\n",
+                   skipped, composer.getDrainRate());
+        }
+        printf("  Tick jitter: %.2f ms mean, %.2f ms stddev, %.2f ms max, %lld dropped\n",
+               scheduler->getMeanJitterMs(), scheduler->getJitterStdDevMs(),
+               scheduler->getMaxJitterMs(), scheduler->getDroppedTicks());
+        if (autopilot && autopilot->getDecisions() > 0) {
+            printf("  Autopilot: %lld decisions, %.1f us mean, %.1f us p99, %.1f us max\n",
+                   autopilot->getDecisions(), autopilot->getMeanMicros(),
+                   autopilot->getPercentileMicros(99), autopilot->getMaxMicros());
+        }
+        if (renderThread) {
+            printf("  Render thread: %lld frames published, %lld drawn, %lld dropped\n",
+                   renderThread->getPublished(), renderThread->getDrawn(),
+                   renderThread->getDropped());
+        }
+        if (planner && planner->getRollouts() > 0) {
+            printf("  Planner: %d threads, %.0f rollouts/sec\n",
+                   planner->getThreadCount(), planner->getRolloutsPerSecond());
+        }
+        if (profiler.isEnabled()) {
+            printf("  Profile: ms/tick input %.3f, sim %.3f, render %.3f, sleep %.2f; %.2f allocs/tick\n",
+                   profiler.getMeanMillis(PHASE_INPUT), profiler.getMeanMillis(PHASE_SIM),
+                   profiler.getMeanMillis(PHASE_RENDER), profiler.getMeanMillis(PHASE_SLEEP),
+                   profiler.getAllocationsPerTick());
+        }
+        if (!recordStatus.empty()) {
+            cout << "  Replay: " << recordStatus << endl;
+        }
         cout << "\n-----------------------------------------" << endl;
         cout << "\n  Options:" << endl;
         cout << "    R : Restart Game" << endl;
         cout << "    Q : Quit to Exit" << endl;
         
-        while (true) {
-            char key = inputHandler->getKey();
+        // Blocks until a key arrives; no polling while idle
+        while (!quitRequested) {
+            char key = inputHandler->waitForKey();
             if (key == 'R') {
                 return true;
             } else if (key == 'Q') {
                 return false;
             }
-            SLEEP(50);
         }
+        return false;
     }
     
     void run() {
         showMenu();
         
         while (running) {
-            // Initialize new game
-            if (board) delete board;
-            board = new GameBoard(20, 40);
+            // Initialize new game. The board, renderer, scheduler, recorder
+            // and render thread are built for the first game and reset for
+            // the next ones, so a restart reuses all of their buffers.
+            if (player) {
+                if (!board) board = player->createBoard();
+                player->seek(*board, 0);
+            } else {
+                uint64_t seed = time(0) ^ monotonicNanos();
+                if (board) {
+                    board->reset(seed);
+                } else {
+                    board = new GameBoard(boardRows, boardCols, seed);
+                    if (scores) board->setHighScore(scores->getBest());
+                }
+                if (recorder) {
+                    recorder->reset(seed);
+                } else if (!recordPath.empty()) {
+                    recorder = new ReplayRecorder(boardRows, boardCols, seed);
+                }
+                // Search buffers are sized to the board once and reused
+                if (!autopilot) autopilot = new Autopilot(boardRows, boardCols);
+                autopilot->reset();
+            }
+            gamesPlayed++;
+            gameTicks = 0;
+            if (!renderer) {
+                renderer = new BoardRenderer();
+                renderer->setMaxLatency(renderInterval);
+                if (profileOverlay) renderer->setStatusLine(profiler.getStatusLine());
+            }
+            
+            // A render thread keeps its own frame period, so only wake for ticks
+            if (!scheduler) {
+                scheduler = new TickScheduler(speed, threadedRender ? speed : renderInterval);
+            }
             
             // Initial render
-            board->renderInitial();
+            renderer->renderInitial(*board);
+            if (threadedRender) {
+                if (!renderThread) renderThread = new RenderThread(renderInterval);
+                renderThread->start(*renderer, *board);
+            }
             
-            // Game loop
-            while (!board->isGameOver()) {
-                board->render();
+            // Game loop: ticks on fixed deadlines, frames at their own rate
+            scheduler->start();
+            bool replayEnded = false;
+            while (running && !board->isGameOver() && !replayEnded) {
+                profiler.mark(PHASE_SLEEP);
+                inputHandler->waitUntil(scheduler->getNextDeadline());
+                if (quitRequested) running = false;
+                int dueTicks = scheduler->collectDueTicks();
                 
-                // Handle input
-                char key = inputHandler->getKey();
-                if (key == 'W' || key == 'U') {
-                    board->getSnake()->setDirection(UP);
-                } else if (key == 'S' || key == 'D') {
-                    board->getSnake()->setDirection(DOWN);
-                } else if (key == 'A' || key == 'L') {
-                    board->getSnake()->setDirection(LEFT);
-                } else if (key == 'D' || key == 'R') {
-                    board->getSnake()->setDirection(RIGHT);
-                } else if (key == 'Q') {
-                    running = false;
-                    break;
+                for (int i = 0; i < dueTicks && running && !board->isGameOver(); i++) {
+                    profiler.mark(PHASE_INPUT);
+                    
+                    // Handle input: at most one effective key per tick
+                    Action action = ACTION_NONE;
+                    char key;
+                    while ((key = inputHandler->popKey()) != KEY_NONE) {
+                        if (applyKey(key, action)) break;
+                    }
+                    if (!running) break;
+                    
+                    // The autopilot overrides the keys while it is on
+                    if (autopilotOn && !player) {
+                        Direction dir = planner ? planner->decide(*board, speed * 0.5)
+                                                : autopilot->decide(*board);
+                        board->getSnake()->setDirection(dir);
+                        action = actionFor(dir);
+                    }
+                    
+                    // A replay supplies the actions; keys only quit
+                    if (player && !player->nextAction(action)) {
+                        replayEnded = true;
+                        break;
+                    }
+                    if (recorder) recorder->record(*board, action);
+                    profiler.mark(PHASE_SIM);
+                    board->step(action);
+                    gameTicks++;
                 }
                 
-                board->update();
-                SLEEP(speed);
+                int bytes = 0;
+                if (renderThread) {
+                    // Publishing only copies the viewport; drawing happens elsewhere
+                    if (dueTicks > 0 && running && !board->isGameOver()) {
+                        profiler.mark(PHASE_RENDER);
+                        renderThread->publish(*renderer, *board);
+                    }
+                } else if (running && !board->isGameOver() && scheduler->renderDue()) {
+                    profiler.mark(PHASE_RENDER);
+                    renderer->render(*board);
+                    bytes = renderer->getComposer().getLastBytes();
+                }
+                profiler.endFrame(dueTicks, bytes);
             }
+            profiler.pause();
+            if (renderThread) renderThread->stop();
+            saveRecording();
+            saveScore();
             
-            if (board->isGameOver()) {
+            if (board->isGameOver() || replayEnded) {
                 bool restart = showGameOver();
                 if (!restart) {
                     running = false;
@@ -582,13 +395,87 @@ public:
         
         showCursor();
         clearScreen();
+        if (!tracePath.empty() && !profiler.writeTrace(tracePath.c_str())) {
+            cerr << "Cannot write trace " << tracePath << endl;
+        }
         cout << "Thanks for playing! Goodbye!" << endl;
     }
 };
 
 // Main function
-int main() {
-    Game game;
+int main(int argc, char* argv[]) {
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    
+    // Optional frame period, independent of the 100 ms simulation tick
+    int renderMs = 100;
+    int rows = 20;
+    int cols = 40;
+    string recordPath;
+    string replayPath;
+    bool autopilot = false;
+    bool mcts = false;
+    bool profile = false;
+    bool renderThread = false;
+    string tracePath;
+    string scoresPath = "snake_scores.log";
+    const char* user = getenv("USER");
+    string playerName = user ? user : "";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--render-ms" && hasValue) {
+            renderMs = atoi(argv[++i]);
+            if (renderMs <= 0) renderMs = 100;
+        } else if (arg == "--rows" && hasValue) {
+            rows = atoi(argv[++i]);
+        } else if (arg == "--cols" && hasValue) {
+            cols = atoi(argv[++i]);
+        } else if (arg == "--record" && hasValue) {
+            recordPath = argv[++i];
+        } else if (arg == "--replay" && hasValue) {
+            replayPath = argv[++i];
+        } else if (arg == "--autopilot") {
+            autopilot = true;
+        } else if (arg == "--mcts") {
+            autopilot = true;
+            mcts = true;
+        } else if (arg == "--render-thread") {
+            renderThread = true;
+        } else if (arg == "--profile") {
+            profile = true;
+        } else if (arg == "--trace" && hasValue) {
+            tracePath = argv[++i];
+        } else if (arg == "--scores" && hasValue) {
+            scoresPath = argv[++i];
+        } else if (arg == "--no-scores") {
+            scoresPath.clear();
+        } else if (arg == "--name" && hasValue) {
+            playerName = argv[++i];
+        }
+    }
+    
+    // Larger boards than the terminal scroll with the snake
+    if (rows < MIN_BOARD_ROWS || cols < MIN_BOARD_COLS || rows > 32766 || cols > 32766) {
+        cerr << "Board must be between 4x6 and 32766x32766" << endl;
+        return 1;
+    }
+    
+    Game game(100, renderMs, rows, cols);
+    if (!replayPath.empty() && !game.openReplay(replayPath)) {
+        cerr << "Cannot read replay " << replayPath << endl;
+        return 1;
+    }
+    if (!recordPath.empty() && replayPath.empty()) {
+        game.setRecordPath(recordPath);
+    }
+    if (!scoresPath.empty() && replayPath.empty()) {
+        game.openScores(scoresPath, playerName);
+    }
+    game.setAutopilot(autopilot);
+    game.setThreadedRender(renderThread);
+    if (mcts) game.useMcts();
+    if (profile || !tracePath.empty()) game.enableProfiler(profile, tracePath);
     game.run();
     return 0;
 }
\ No newline at end of file
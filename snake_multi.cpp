@@ -0,0 +1,211 @@
+#include "snake_multi.h"
+
+#include <algorithm>
+
+using namespace std;
+
+MultiBoard::MultiBoard(int r, int c, int maxPlayers, int foodCount, uint64_t seed)
+    : rows(r), cols(c), grid(r, c),
+      // Room for every snake's moves plus some deaths; more than that and
+      // the list overflows and clients are sent a snapshot instead
+      changes(4 * maxPlayers + 2 * foodCount + 4096),
+      changeOwners(4 * maxPlayers + 2 * foodCount + 4096, NO_OWNER),
+      players(min(maxPlayers, (int)MAX_PLAYERS)), foods(foodCount, Position(-1, -1)),
+      foodAt((size_t)r * c, 0), isChanged(players.size(), 0), dying(players.size(), 0), rng(seed), tick(0), respawnDelay(10) {
+    for (Player& player : players) {
+        player.snake = NULL;
+        player.active = false;
+        player.score = 0;
+        player.respawnIn = 0;
+        player.action = ACTION_NONE;
+    }
+    changedPlayers.reserve(players.size());
+    landings.reserve(players.size());
+    for (int i = 0; i < foodCount; i++) {
+        spawnFood(i);
+    }
+}
+
+MultiBoard::~MultiBoard() {
+    for (Player& player : players) {
+        delete player.snake;
+    }
+}
+
+void MultiBoard::claimChanges(int from, int owner) {
+    for (int i = from; i < changes.size(); i++) {
+        changeOwners[i] = owner;
+    }
+}
+
+void MultiBoard::markChanged(int id) {
+    if (!isChanged[id]) {
+        isChanged[id] = 1;
+        changedPlayers.push_back(id);
+    }
+}
+
+// New snakes start as the single-player one does, length 3 heading right,
+// so they need three free cells in a row and one more ahead
+bool MultiBoard::spawn(int id) {
+    for (int attempt = 0; attempt < 64; attempt++) {
+        int freeCount = grid.getFreeCount();
+        if (freeCount == 0) return false;
+        Position head = grid.getFreeCell(rng.nextBelow(freeCount));
+        bool roomy = head.col >= 3 && head.col + 1 < cols - 1;
+        for (int dc = -2; dc <= 1 && roomy; dc++) {
+            Position pos(head.row, head.col + dc);
+            roomy = !grid.isOccupied(pos) && !foodAt[cellOf(pos)];
+        }
+        if (!roomy) continue;
+
+        int before = changes.size();
+        players[id].snake = new Snake(head, &grid, &changes, rows * cols);
+        claimChanges(before, id);
+        players[id].score = 0;
+        markChanged(id);
+        return true;
+    }
+    return false;
+}
+
+void MultiBoard::spawnFood(int index) {
+    int freeCount = grid.getFreeCount();
+    for (int attempt = 0; attempt < 64 && freeCount > 0; attempt++) {
+        Position pos = grid.getFreeCell(rng.nextBelow(freeCount));
+        if (foodAt[cellOf(pos)]) continue;
+        foods[index] = pos;
+        foodAt[cellOf(pos)] = 1;
+        int before = changes.size();
+        changes.add(pos, CELL_FOOD);
+        claimChanges(before, NO_OWNER);
+        return;
+    }
+    // No room; try again when something dies
+    foods[index] = Position(-1, -1);
+}
+
+void MultiBoard::removeBody(int id, int cells) {
+    Snake* snake = players[id].snake;
+    int before = changes.size();
+    for (const Position& pos : snake->getBody()) {
+        if (cells-- == 0) break;
+        grid.release(pos);
+        changes.add(pos, CELL_EMPTY);
+    }
+    claimChanges(before, id);
+    delete snake;
+    players[id].snake = NULL;
+}
+
+int MultiBoard::addPlayer() {
+    for (size_t id = 0; id < players.size(); id++) {
+        if (players[id].active) continue;
+        players[id].active = true;
+        players[id].score = 0;
+        players[id].respawnIn = 0;
+        players[id].action = ACTION_NONE;
+        spawn(id);
+        markChanged(id);
+        return id;
+    }
+    return -1;
+}
+
+void MultiBoard::removePlayer(int id) {
+    if (players[id].snake) removeBody(id, players[id].snake->getLength());
+    players[id].active = false;
+    markChanged(id);
+}
+
+void MultiBoard::setAction(int id, Action action) {
+    players[id].action = action;
+}
+
+void MultiBoard::clearChanges() {
+    changes.clear();
+    for (uint16_t id : changedPlayers) {
+        isChanged[id] = 0;
+    }
+    changedPlayers.clear();
+}
+
+void MultiBoard::step() {
+    tick++;
+    int count = players.size();
+
+    // Dead players come back after a while; food that found no room retries
+    for (int id = 0; id < count; id++) {
+        Player& player = players[id];
+        if (player.active && !player.snake && --player.respawnIn <= 0 && !spawn(id)) {
+            player.respawnIn = 1;
+        }
+    }
+    for (size_t i = 0; i < foods.size(); i++) {
+        if (foods[i].row < 0) spawnFood(i);
+    }
+
+    // Every tail leaves before any head lands
+    for (int id = 0; id < count; id++) {
+        Player& player = players[id];
+        if (!player.snake) continue;
+        if (player.action != ACTION_NONE) {
+            player.snake->setDirection((Direction)(player.action - ACTION_UP));
+            player.action = ACTION_NONE;
+        }
+        int before = changes.size();
+        player.snake->vacateTail();
+        claimChanges(before, id);
+    }
+
+    // Decide every collision against the board as it is now
+    landings.clear();
+    for (int id = 0; id < count; id++) {
+        const Snake* snake = players[id].snake;
+        if (!snake) continue;
+        Position next = stepFrom(snake->getHead(), snake->getDirection());
+        dying[id] = !isInterior(next) || grid.isOccupied(next);
+        if (!dying[id]) landings.push_back(((uint64_t)cellOf(next) << 16) | id);
+    }
+    sort(landings.begin(), landings.end());
+    for (size_t i = 1; i < landings.size(); i++) {
+        if ((landings[i] >> 16) == (landings[i - 1] >> 16)) {
+            dying[landings[i] & 0xFFFF] = 1;
+            dying[landings[i - 1] & 0xFFFF] = 1;
+        }
+    }
+
+    // Survivors land and eat
+    for (int id = 0; id < count; id++) {
+        Player& player = players[id];
+        if (!player.snake || dying[id]) continue;
+        int before = changes.size();
+        player.snake->advanceHead();
+        claimChanges(before, id);
+
+        int cell = cellOf(player.snake->getHead());
+        if (foodAt[cell]) {
+            foodAt[cell] = 0;
+            player.snake->grow();
+            player.score += 10;
+            markChanged(id);
+            for (size_t i = 0; i < foods.size(); i++) {
+                if (foods[i] == player.snake->getHead()) {
+                    spawnFood(i);
+                    break;
+                }
+            }
+        }
+    }
+
+    // A snake that did not land has let go of its tail but still counts
+    // it, so its body is one cell shorter than its length
+    for (int id = 0; id < count; id++) {
+        if (players[id].snake && dying[id]) {
+            removeBody(id, players[id].snake->getLength() - 1);
+            players[id].respawnIn = respawnDelay;
+            markChanged(id);
+        }
+        dying[id] = 0;
+    }
+}
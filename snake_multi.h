@@ -0,0 +1,97 @@
+// Several snakes on one board, for the multiplayer server. The snakes
+// share one occupancy grid and one change list. Each tick every tail
+// leaves first, then every head's landing cell is checked against the
+// grid, the walls and the other heads before any head lands, so the result
+// does not depend on the order players are stored in. A snake that hits
+// anything dies (both of them, head to head), its body is cleared and it
+// respawns a few ticks later for as long as its player stays.
+#ifndef SNAKE_MULTI_H
+#define SNAKE_MULTI_H
+
+#include <cstdint>
+#include <vector>
+
+#include "snake_engine.h"
+
+class MultiBoard {
+public:
+    static const int NO_OWNER = 0x3FFF;    // owner of food changes
+    static const int MAX_PLAYERS = NO_OWNER;
+
+private:
+    struct Player {
+        Snake* snake;        // NULL while dead or not in the game
+        bool active;
+        int score;
+        int respawnIn;       // ticks until the next spawn attempt
+        Action action;       // applied at the next tick
+    };
+
+    int rows;
+    int cols;
+    OccupancyGrid grid;
+    CellChangeList changes;
+    std::vector<uint16_t> changeOwners;     // player behind each change
+    std::vector<Player> players;
+    std::vector<Position> foods;
+    std::vector<uint8_t> foodAt;            // 1 where a food sits, per cell
+    std::vector<uint16_t> changedPlayers;   // score or life changed this tick
+    std::vector<uint8_t> isChanged;         // already in changedPlayers
+    std::vector<uint64_t> landings;         // (cell << 16) | id, for head to head
+    std::vector<uint8_t> dying;
+    Rng rng;
+    uint32_t tick;
+    int respawnDelay;
+
+    int cellOf(Position pos) const { return pos.row * cols + pos.col; }
+
+    bool isInterior(Position pos) const {
+        return pos.row > 0 && pos.row < rows - 1 && pos.col > 0 && pos.col < cols - 1;
+    }
+
+    // Changes added since from belong to owner
+    void claimChanges(int from, int owner);
+
+    void markChanged(int id);
+    bool spawn(int id);
+    void spawnFood(int index);
+
+    // Clear the first cells of a snake's body, from the head, off the board
+    void removeBody(int id, int cells);
+
+public:
+    MultiBoard(int r, int c, int maxPlayers, int foodCount, uint64_t seed);
+    ~MultiBoard();
+
+    // Join a new player; returns its id, or -1 when the board is full
+    int addPlayer();
+    void removePlayer(int id);
+
+    // Queue a turn for the player's next tick
+    void setAction(int id, Action action);
+
+    // Advance every snake one tick
+    void step();
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    uint32_t getTick() const { return tick; }
+    int getMaxPlayers() const { return players.size(); }
+    bool isActive(int id) const { return players[id].active; }
+    bool isAlive(int id) const { return players[id].snake != NULL; }
+    int getScore(int id) const { return players[id].score; }
+    const Snake* getSnake(int id) const { return players[id].snake; }
+    const std::vector<Position>& getFoods() const { return foods; }
+
+    // Cell changes since the last clearChanges(), from steps, joins and
+    // leaves alike, each with the player it belongs to
+    const CellChangeList& getChanges() const { return changes; }
+    int getChangeOwner(int i) const { return changeOwners[i]; }
+
+    // Players whose score or life changed since the last clearChanges()
+    const std::vector<uint16_t>& getChangedPlayers() const { return changedPlayers; }
+
+    void clearChanges();
+};
+
+#endif
@@ -0,0 +1,323 @@
+#include "snake_net.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+using namespace std;
+
+static const size_t CELL_RECORD = 6;
+static const size_t STATUS_RECORD = 7;
+static const size_t SNAPSHOT_HEADER = 1 + 4 + 2 + 2 + 2 + 2 + 4 + 2;
+static const size_t DELTA_HEADER = 1 + 4 + 4 + 2;
+
+template <typename T>
+static uint8_t* put(uint8_t* out, T value) {
+    memcpy(out, &value, sizeof(T));
+    return out + sizeof(T);
+}
+
+template <typename T>
+static const uint8_t* get(const uint8_t* in, T& value) {
+    memcpy(&value, in, sizeof(T));
+    return in + sizeof(T);
+}
+
+// Grow out by one frame of payloadSize bytes; returns where the payload goes
+static uint8_t* beginFrame(vector<uint8_t>& out, size_t payloadSize) {
+    size_t at = out.size();
+    out.resize(at + 4 + payloadSize);
+    return put(out.data() + at, (uint32_t)payloadSize);
+}
+
+static uint8_t* putCell(uint8_t* out, Position pos, CellKind kind, int owner) {
+    out = put(out, (uint16_t)pos.row);
+    out = put(out, (uint16_t)pos.col);
+    return put(out, (uint16_t)((kind << 14) | owner));
+}
+
+static uint8_t* putStatus(uint8_t* out, const MultiBoard& board, int id) {
+    uint8_t flags = (board.isActive(id) ? STATUS_ACTIVE : 0) | (board.isAlive(id) ? STATUS_ALIVE : 0);
+    out = put(out, (uint16_t)id);
+    out = put(out, flags);
+    return put(out, (int32_t)board.getScore(id));
+}
+
+void encodeSnapshot(const MultiBoard& board, int yourId, vector<uint8_t>& out) {
+    int maxPlayers = board.getMaxPlayers();
+    uint32_t cellCount = 0;
+    uint16_t statusCount = 0;
+    for (int id = 0; id < maxPlayers; id++) {
+        if (board.isActive(id)) statusCount++;
+        if (board.isAlive(id)) cellCount += board.getSnake(id)->getLength();
+    }
+    for (const Position& food : board.getFoods()) {
+        if (food.row >= 0) cellCount++;
+    }
+
+    uint8_t* p = beginFrame(out, SNAPSHOT_HEADER + cellCount * CELL_RECORD + statusCount * STATUS_RECORD);
+    p = put(p, (uint8_t)MSG_SNAPSHOT);
+    p = put(p, board.getTick());
+    p = put(p, (uint16_t)board.getRows());
+    p = put(p, (uint16_t)board.getCols());
+    p = put(p, (uint16_t)yourId);
+    p = put(p, (uint16_t)maxPlayers);
+    p = put(p, cellCount);
+    p = put(p, statusCount);
+    for (int id = 0; id < maxPlayers; id++) {
+        if (!board.isAlive(id)) continue;
+        const Snake* snake = board.getSnake(id);
+        for (const Position& pos : snake->getBody()) {
+            p = putCell(p, pos, pos == snake->getHead() ? CELL_HEAD : CELL_BODY, id);
+        }
+    }
+    for (const Position& food : board.getFoods()) {
+        if (food.row >= 0) p = putCell(p, food, CELL_FOOD, MultiBoard::NO_OWNER);
+    }
+    for (int id = 0; id < maxPlayers; id++) {
+        if (board.isActive(id)) p = putStatus(p, board, id);
+    }
+}
+
+void encodeDelta(const MultiBoard& board, vector<uint8_t>& out) {
+    const CellChangeList& changes = board.getChanges();
+    const vector<uint16_t>& changed = board.getChangedPlayers();
+
+    uint8_t* p = beginFrame(out, DELTA_HEADER + changes.size() * CELL_RECORD + changed.size() * STATUS_RECORD);
+    p = put(p, (uint8_t)MSG_DELTA);
+    p = put(p, board.getTick());
+    p = put(p, (uint32_t)changes.size());
+    p = put(p, (uint16_t)changed.size());
+    for (int i = 0; i < changes.size(); i++) {
+        p = putCell(p, changes[i].pos, changes[i].kind, board.getChangeOwner(i));
+    }
+    for (uint16_t id : changed) {
+        p = putStatus(p, board, id);
+    }
+}
+
+void encodeTurn(Action action, vector<uint8_t>& out) {
+    uint8_t* p = beginFrame(out, 2);
+    p = put(p, (uint8_t)MSG_TURN);
+    put(p, (uint8_t)action);
+}
+
+void FrameReader::append(const uint8_t* data, size_t size) {
+    // Drop what has been read before growing
+    if (start > 0 && start * 2 >= buffer.size()) {
+        buffer.erase(buffer.begin(), buffer.begin() + start);
+        start = 0;
+    }
+    buffer.insert(buffer.end(), data, data + size);
+}
+
+bool FrameReader::next(const uint8_t*& payload, uint32_t& size) {
+    if (buffer.size() - start < 4) return false;
+    get(buffer.data() + start, size);
+    if (buffer.size() - start - 4 < size) return false;
+    payload = buffer.data() + start + 4;
+    start += 4 + size;
+    return true;
+}
+
+BoardMirror::BoardMirror()
+    : rows(0), cols(0), yourId(-1), tick(0), head(-1, -1), direction(RIGHT) {}
+
+void BoardMirror::setCell(int row, int col, int kind, int owner) {
+    int cell = row * cols + col;
+    if (kinds[cell] == CELL_FOOD && kind != CELL_FOOD) {
+        for (size_t i = 0; i < foods.size(); i++) {
+            if (foods[i] == Position(row, col)) {
+                foods[i] = foods.back();
+                foods.pop_back();
+                break;
+            }
+        }
+    } else if (kind == CELL_FOOD && kinds[cell] != CELL_FOOD) {
+        foods.push_back(Position(row, col));
+    }
+    kinds[cell] = kind;
+    owners[cell] = owner;
+
+    if (kind == CELL_HEAD && owner == yourId) {
+        // A step from the old head gives our heading; anything else is a
+        // fresh spawn, which always faces right
+        Position pos(row, col);
+        int dr = pos.row - head.row;
+        int dc = pos.col - head.col;
+        if (head.row < 0 || abs(dr) + abs(dc) != 1) {
+            if (!(pos == head)) direction = RIGHT;
+        } else {
+            direction = dr < 0 ? UP : dr > 0 ? DOWN : dc < 0 ? LEFT : RIGHT;
+        }
+        head = pos;
+    }
+}
+
+bool BoardMirror::readStatuses(const uint8_t* data, const uint8_t* end, int count) {
+    for (int i = 0; i < count; i++) {
+        if (end - data < (ptrdiff_t)STATUS_RECORD) return false;
+        uint16_t id;
+        uint8_t flags;
+        int32_t score;
+        data = get(data, id);
+        data = get(data, flags);
+        data = get(data, score);
+        if (id >= statuses.size()) return false;
+        statuses[id].flags = flags;
+        statuses[id].score = score;
+    }
+    if (yourId >= 0 && !isAlive(yourId)) head = Position(-1, -1);
+    return true;
+}
+
+bool BoardMirror::apply(const uint8_t* payload, uint32_t size) {
+    const uint8_t* end = payload + size;
+    if (size < 1) return false;
+    uint8_t type = payload[0];
+    const uint8_t* p = payload + 1;
+    uint32_t cellCount;
+    uint16_t statusCount;
+
+    if (type == MSG_SNAPSHOT) {
+        if (size < SNAPSHOT_HEADER) return false;
+        uint16_t r, c, id, maxPlayers;
+        p = get(p, tick);
+        p = get(p, r);
+        p = get(p, c);
+        p = get(p, id);
+        p = get(p, maxPlayers);
+        p = get(p, cellCount);
+        p = get(p, statusCount);
+        if (id >= maxPlayers) return false;
+        rows = r;
+        cols = c;
+        yourId = id;
+        kinds.assign((size_t)rows * cols, CELL_EMPTY);
+        owners.assign((size_t)rows * cols, MultiBoard::NO_OWNER);
+        statuses.assign(maxPlayers, Status());
+        foods.clear();
+    } else if (type == MSG_DELTA) {
+        if (size < DELTA_HEADER || !isReady()) return false;
+        p = get(p, tick);
+        p = get(p, cellCount);
+        p = get(p, statusCount);
+    } else {
+        return false;
+    }
+
+    if ((size_t)(end - p) < (size_t)cellCount * CELL_RECORD) return false;
+    for (uint32_t i = 0; i < cellCount; i++) {
+        uint16_t row, col, packed;
+        p = get(p, row);
+        p = get(p, col);
+        p = get(p, packed);
+        if (row >= rows || col >= cols) return false;
+        setCell(row, col, packed >> 14, packed & 0x3FFF);
+    }
+    return readStatuses(p, end, statusCount);
+}
+
+#ifndef _WIN32
+static bool splitAddress(const string& address, string& scheme, string& rest) {
+    size_t colon = address.find(':');
+    if (colon == string::npos) return false;
+    scheme = address.substr(0, colon);
+    rest = address.substr(colon + 1);
+    return (scheme == "unix" || scheme == "tcp") && !rest.empty();
+}
+
+static int openSocket(const string& address, bool listening) {
+    string scheme, rest;
+    if (!splitAddress(address, scheme, rest)) {
+        fprintf(stderr, "Bad address '%s'; use unix:PATH or tcp:PORT\n", address.c_str());
+        return -1;
+    }
+
+    sockaddr_un unixAddr;
+    sockaddr_in tcpAddr;
+    sockaddr* addr;
+    socklen_t addrLen;
+    int fd;
+    if (scheme == "unix") {
+        if (rest.size() >= sizeof(unixAddr.sun_path)) {
+            fprintf(stderr, "Socket path too long: %s\n", rest.c_str());
+            return -1;
+        }
+        memset(&unixAddr, 0, sizeof(unixAddr));
+        unixAddr.sun_family = AF_UNIX;
+        memcpy(unixAddr.sun_path, rest.c_str(), rest.size());
+        addr = (sockaddr*)&unixAddr;
+        addrLen = sizeof(unixAddr);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listening) unlink(rest.c_str());
+    } else {
+        memset(&tcpAddr, 0, sizeof(tcpAddr));
+        tcpAddr.sin_family = AF_INET;
+        tcpAddr.sin_port = htons((uint16_t)atoi(rest.c_str()));
+        tcpAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr = (sockaddr*)&tcpAddr;
+        addrLen = sizeof(tcpAddr);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+    }
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    int one = 1;
+    if (scheme == "tcp") {
+        // Deltas are small and latency matters more than packet count
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (listening) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    }
+    if (listening) {
+        if (bind(fd, addr, addrLen) < 0 || listen(fd, 1024) < 0) {
+            perror(address.c_str());
+            close(fd);
+            return -1;
+        }
+    } else if (connect(fd, addr, addrLen) < 0) {
+        perror(address.c_str());
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int listenOn(const string& address) {
+    return openSocket(address, true);
+}
+
+int connectTo(const string& address) {
+    return openSocket(address, false);
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+#else
+int listenOn(const string&) {
+    fprintf(stderr, "Networking is not supported on Windows\n");
+    return -1;
+}
+
+int connectTo(const string&) {
+    fprintf(stderr, "Networking is not supported on Windows\n");
+    return -1;
+}
+
+bool setNonBlocking(int) {
+    return false;
+}
+#endif
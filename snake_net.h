@@ -0,0 +1,115 @@
+// Wire format and sockets for the multiplayer server. Every message is a
+// u32 payload length followed by the payload, whose first byte is its
+// type; numbers are in host byte order, as in replay files, since server
+// and clients share a machine (Unix domain socket or loopback TCP).
+//
+//   SNAPSHOT  type u8 | tick u32 | rows u16 | cols u16 | yourId u16 |
+//             maxPlayers u16 | cellCount u32 | statusCount u16 |
+//             cells | statuses
+//   DELTA     type u8 | tick u32 | cellCount u32 | statusCount u16 |
+//             cells | statuses
+//   TURN      type u8 | action u8              (client to server)
+//
+// A cell record is 6 bytes: row u16, col u16, then kind << 14 | owner.
+// A snapshot lists every non-empty cell; a delta lists only the cells that
+// changed since the last tick. A status record is 7 bytes: id u16, flags
+// u8 (STATUS_ACTIVE, STATUS_ALIVE), score i32.
+#ifndef SNAKE_NET_H
+#define SNAKE_NET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "snake_engine.h"
+#include "snake_multi.h"
+
+enum MessageType {
+    MSG_SNAPSHOT = 1,
+    MSG_DELTA = 2,
+    MSG_TURN = 3
+};
+
+enum StatusFlags {
+    STATUS_ACTIVE = 1,
+    STATUS_ALIVE = 2
+};
+
+// Append one framed message to out
+void encodeSnapshot(const MultiBoard& board, int yourId, std::vector<uint8_t>& out);
+void encodeDelta(const MultiBoard& board, std::vector<uint8_t>& out);
+void encodeTurn(Action action, std::vector<uint8_t>& out);
+
+// Splits a byte stream back into message payloads
+class FrameReader {
+private:
+    std::vector<uint8_t> buffer;
+    size_t start;
+
+public:
+    FrameReader() : start(0) {}
+
+    void append(const uint8_t* data, size_t size);
+
+    // The next complete payload, valid until the next append()
+    bool next(const uint8_t*& payload, uint32_t& size);
+
+    size_t getBuffered() const { return buffer.size() - start; }
+};
+
+// A client's copy of the board, kept up to date from snapshots and deltas
+class BoardMirror {
+private:
+    struct Status {
+        uint8_t flags;
+        int score;
+    };
+
+    int rows;
+    int cols;
+    int yourId;
+    uint32_t tick;
+    std::vector<uint8_t> kinds;        // CellKind per cell
+    std::vector<uint16_t> owners;
+    std::vector<Status> statuses;
+    std::vector<Position> foods;
+    Position head;                      // our own snake's
+    Direction direction;
+
+    void setCell(int row, int col, int kind, int owner);
+    bool readStatuses(const uint8_t* data, const uint8_t* end, int count);
+
+public:
+    BoardMirror();
+
+    // Apply a SNAPSHOT or DELTA payload; false if it is malformed or a
+    // delta arrives before the first snapshot
+    bool apply(const uint8_t* payload, uint32_t size);
+
+    bool isReady() const { return rows > 0; }
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    int getYourId() const { return yourId; }
+    uint32_t getTick() const { return tick; }
+
+    CellKind getCell(Position pos) const { return (CellKind)kinds[pos.row * cols + pos.col]; }
+    int getOwner(Position pos) const { return owners[pos.row * cols + pos.col]; }
+    const std::vector<Position>& getFoods() const { return foods; }
+
+    bool isAlive(int id) const { return statuses[id].flags & STATUS_ALIVE; }
+    int getScore(int id) const { return statuses[id].score; }
+
+    // Where our snake's head is and which way it last moved
+    Position getHead() const { return head; }
+    Direction getDirection() const { return direction; }
+};
+
+// "unix:PATH" or "tcp:PORT" (loopback only). Both return a socket or -1
+// with a message on stderr; neither is available on Windows.
+int listenOn(const std::string& address);
+int connectTo(const std::string& address);
+
+bool setNonBlocking(int fd);
+
+#endif
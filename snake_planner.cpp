@@ -0,0 +1,190 @@
+#include "snake_planner.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+static const double DISCOUNT = 0.97;
+static const double EXPLORATION = 1.0;
+
+static long long nowNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Would moving onto pos this tick be survivable?
+static bool isSafe(const GameBoard& board, Position pos) {
+    if (pos.row <= 0 || pos.row >= board.getRows() - 1 ||
+        pos.col <= 0 || pos.col >= board.getCols() - 1) {
+        return false;
+    }
+    if (!board.isOccupied(pos)) return true;
+    return pos == board.getTail() && !board.getSnake()->isGrowing();
+}
+
+MctsPlanner::MctsPlanner(int rows, int cols, int threads, uint64_t seed, int depth, int arenaNodes)
+    : pool(threads), rolloutDepth(depth), totalRollouts(0), lastRollouts(0), totalSeconds(0) {
+    for (int i = 0; i < pool.size(); i++) {
+        workers.emplace_back(new Worker(this, rows, cols, arenaNodes, splitmix64(seed + i)));
+    }
+}
+
+double MctsPlanner::advance(GameBoard& board, Direction dir, double weight) {
+    StepResult result = board.step(actionFor(dir));
+    if (result.gameOver) return -weight;
+    return result.ateFood ? weight : 0;
+}
+
+Direction MctsPlanner::rolloutDirection(const GameBoard& board, Rng& rng) {
+    Position head = board.getHead();
+    Position food = board.getFoodPosition();
+    Direction current = board.getSnake()->getDirection();
+
+    Direction safe[3];
+    int safeCount = 0;
+    int bestDistance = 1 << 30;
+    Direction best = current;
+    for (int d = 0; d < 4; d++) {
+        if (d == (current ^ 1)) continue;
+        Position next = stepFrom(head, (Direction)d);
+        if (!isSafe(board, next)) continue;
+        safe[safeCount++] = (Direction)d;
+        int distance = abs(next.row - food.row) + abs(next.col - food.col);
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = (Direction)d;
+        }
+    }
+    if (safeCount == 0) return current;
+    if (rng.nextBelow(4) == 0) return safe[rng.nextBelow(safeCount)];
+    return best;
+}
+
+void MctsPlanner::searchTree(Worker& worker, const GameBoard& root, long long deadlineNanos) {
+    vector<Node>& nodes = worker.nodes;
+    Node& rootNode = nodes[0];
+    rootNode.firstChild = -1;
+    rootNode.childCount = 0;
+    rootNode.dir = root.getSnake()->getDirection();
+    rootNode.visits = 0;
+    rootNode.value = 0;
+    worker.nodeCount = 1;
+    worker.rollouts = 0;
+
+    int path[MAX_TREE_DEPTH + 1];
+    while (nowNanos() < deadlineNanos) {
+        GameBoard& board = worker.scratch;
+        board = root;
+        board.reseed(worker.rng.next());
+
+        // Selection: descend by UCB1 while the nodes are expanded
+        int depth = 0;
+        int node = 0;
+        path[depth++] = node;
+        double total = 0;
+        double weight = 1;
+        while (nodes[node].firstChild >= 0 && !board.isGameOver() && depth <= MAX_TREE_DEPTH) {
+            const Node& parent = nodes[node];
+            double logVisits = log((double)parent.visits + 1);
+            int chosen = parent.firstChild;
+            double bestScore = -1e300;
+            for (int c = parent.firstChild; c < parent.firstChild + parent.childCount; c++) {
+                double score = nodes[c].visits == 0
+                    ? 1e300
+                    : nodes[c].value / nodes[c].visits +
+                      EXPLORATION * sqrt(logVisits / nodes[c].visits);
+                if (score > bestScore) {
+                    bestScore = score;
+                    chosen = c;
+                }
+            }
+            node = chosen;
+            path[depth++] = node;
+            total += advance(board, (Direction)nodes[node].dir, weight);
+            weight *= DISCOUNT;
+        }
+
+        // Expansion: one child per non-reversing move, if the arena has room
+        Node& leaf = nodes[node];
+        if (!board.isGameOver() && depth <= MAX_TREE_DEPTH &&
+            worker.nodeCount + 3 <= (int)nodes.size()) {
+            Direction current = board.getSnake()->getDirection();
+            leaf.firstChild = worker.nodeCount;
+            leaf.childCount = 0;
+            for (int d = 0; d < 4; d++) {
+                if (d == (current ^ 1)) continue;
+                Node& child = nodes[worker.nodeCount++];
+                child.firstChild = -1;
+                child.childCount = 0;
+                child.dir = d;
+                child.visits = 0;
+                child.value = 0;
+                leaf.childCount++;
+            }
+            node = leaf.firstChild + worker.rng.nextBelow(leaf.childCount);
+            path[depth++] = node;
+            total += advance(board, (Direction)nodes[node].dir, weight);
+            weight *= DISCOUNT;
+        }
+
+        // Rollout
+        for (int step = 0; step < rolloutDepth && !board.isGameOver(); step++) {
+            total += advance(board, rolloutDirection(board, worker.rng), weight);
+            weight *= DISCOUNT;
+        }
+
+        // Backpropagation
+        for (int i = 0; i < depth; i++) {
+            nodes[path[i]].visits++;
+            nodes[path[i]].value += total;
+        }
+        worker.rollouts++;
+    }
+}
+
+void MctsPlanner::runWorker(void* context) {
+    Worker* worker = (Worker*)context;
+    worker->planner->searchTree(*worker, *worker->root, worker->deadline);
+}
+
+Direction MctsPlanner::decide(const GameBoard& board, double budgetMs) {
+    Direction current = board.getSnake()->getDirection();
+    if (board.isGameOver()) return current;
+
+    long long start = nowNanos();
+    long long deadline = start + (long long)(budgetMs * 1e6);
+    for (size_t i = 0; i < workers.size(); i++) {
+        Worker* worker = workers[i].get();
+        worker->root = &board;
+        worker->deadline = deadline;
+        pool.submit(runWorker, worker);
+    }
+    pool.wait();
+
+    // Sum the root children over every tree
+    double visits[4] = { 0, 0, 0, 0 };
+    double values[4] = { 0, 0, 0, 0 };
+    lastRollouts = 0;
+    for (const unique_ptr<Worker>& worker : workers) {
+        const Node& root = worker->nodes[0];
+        for (int c = root.firstChild; root.firstChild >= 0 && c < root.firstChild + root.childCount; c++) {
+            visits[worker->nodes[c].dir] += worker->nodes[c].visits;
+            values[worker->nodes[c].dir] += worker->nodes[c].value;
+        }
+        lastRollouts += worker->rollouts;
+    }
+    totalRollouts += lastRollouts;
+    totalSeconds += (nowNanos() - start) / 1e9;
+
+    Direction best = current;
+    for (int d = 0; d < 4; d++) {
+        if (visits[d] > visits[best] ||
+            (visits[d] == visits[best] && visits[d] > 0 &&
+             values[d] / visits[d] > values[best] / visits[best])) {
+            best = (Direction)d;
+        }
+    }
+    return best;
+}
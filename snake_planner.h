@@ -0,0 +1,90 @@
+// Monte Carlo tree search planner. Every tick each worker thread grows its
+// own UCT tree from the current state until the time budget runs out, with
+// a short heuristic rollout from each new leaf; the root visit counts are
+// then summed over the workers and the most visited direction wins. The
+// trees are independent (root parallelisation), so the threads share
+// nothing and take no locks while searching.
+//
+// A worker owns everything it touches: a scratch GameBoard reset to the
+// root by assignment (same size, so its buffers are reused), a fixed arena
+// of tree nodes and its own Rng. Rollouts reseed the scratch board's food
+// RNG so they cannot foresee where real food will appear.
+#ifndef SNAKE_PLANNER_H
+#define SNAKE_PLANNER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "snake_engine.h"
+#include "work_pool.h"
+
+class MctsPlanner {
+private:
+    static const int MAX_TREE_DEPTH = 64;
+
+    struct Node {
+        int32_t firstChild;   // index of the first child in the arena, -1 if unexpanded
+        uint8_t childCount;
+        uint8_t dir;          // move that led here
+        uint32_t visits;
+        double value;         // sum of the returns backed up through here
+    };
+
+    struct Worker {
+        GameBoard scratch;
+        std::vector<Node> nodes;
+        int nodeCount;
+        Rng rng;
+        long long rollouts;
+
+        // This tick's search, handed to the pool as the task context so
+        // submitting it does not allocate
+        MctsPlanner* planner;
+        const GameBoard* root;
+        long long deadline;
+
+        Worker(MctsPlanner* owner, int rows, int cols, int arenaNodes, uint64_t seed)
+            : scratch(rows, cols), nodes(arenaNodes), nodeCount(0), rng(seed), rollouts(0),
+              planner(owner), root(NULL), deadline(0) {}
+    };
+
+    std::vector<std::unique_ptr<Worker> > workers;
+    WorkStealingPool pool;
+    int rolloutDepth;
+    long long totalRollouts;
+    long long lastRollouts;
+    double totalSeconds;
+
+    // Step the scratch board; returns the reward for that tick
+    static double advance(GameBoard& board, Direction dir, double weight);
+
+    // Cheap rollout policy: mostly the safe move nearest the food,
+    // sometimes a random safe one
+    static Direction rolloutDirection(const GameBoard& board, Rng& rng);
+
+    // Grow one worker's tree from root until the deadline
+    void searchTree(Worker& worker, const GameBoard& root, long long deadlineNanos);
+
+    // Pool task: run searchTree() for the Worker passed as context
+    static void runWorker(void* context);
+
+public:
+    // threads <= 0 uses every core; each worker keeps arenaNodes tree nodes
+    MctsPlanner(int rows, int cols, int threads = 0, uint64_t seed = 1,
+                int depth = 40, int arenaNodes = 1 << 16);
+
+    // Search for up to budgetMs and return the direction to take
+    Direction decide(const GameBoard& board, double budgetMs);
+
+    Action nextAction(const GameBoard& board, double budgetMs) {
+        return actionFor(decide(board, budgetMs));
+    }
+
+    int getThreadCount() const { return workers.size(); }
+    long long getRollouts() const { return totalRollouts; }
+    long long getLastRollouts() const { return lastRollouts; }
+    double getRolloutsPerSecond() const { return totalSeconds > 0 ? totalRollouts / totalSeconds : 0; }
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include "snake_profiler.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "snake_terminal.h"
+
+using namespace std;
+
+atomic<long long> heapAllocations(0);
+
+// Every heap allocation in the process goes through here
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static const char* const PHASE_NAMES[PHASE_COUNT] = { "input", "sim", "render", "sleep" };
+
+static const long long WINDOW_NANOS = 500000000LL;
+
+FrameProfiler::FrameProfiler()
+    : enabled(false), current(-1), phaseStart(0), origin(0), lastAllocations(0),
+      windowStart(0), windowTicks(0), windowFrames(0), windowBytes(0), windowAllocations(0),
+      totalTicks(0), totalAllocations(0), spanCount(0), sampleCount(0), droppedSpans(0) {
+    memset(windowNanos, 0, sizeof(windowNanos));
+    memset(totalNanos, 0, sizeof(totalNanos));
+    statusLine[0] = '\0';
+}
+
+void FrameProfiler::enable(size_t traceSpans) {
+    spans.resize(traceSpans);
+    samples.resize(traceSpans / 4);
+    enabled = true;
+    origin = monotonicNanos();
+    windowStart = origin;
+    lastAllocations = heapAllocations.load(memory_order_relaxed);
+    snprintf(statusLine, sizeof(statusLine), "Profile: measuring...");
+}
+
+void FrameProfiler::switchTo(int phase) {
+    long long now = monotonicNanos();
+    if (current >= 0) {
+        long long duration = now - phaseStart;
+        windowNanos[current] += duration;
+        totalNanos[current] += duration;
+        if (spanCount < spans.size()) {
+            Span& span = spans[spanCount++];
+            span.start = phaseStart;
+            span.duration = duration;
+            span.phase = current;
+        } else {
+            droppedSpans++;
+        }
+    }
+    current = phase;
+    phaseStart = now;
+}
+
+void FrameProfiler::closeFrame(int ticks, int bytes) {
+    long long allocations = heapAllocations.load(memory_order_relaxed);
+    long long newAllocations = allocations - lastAllocations;
+    lastAllocations = allocations;
+
+    windowTicks += ticks;
+    windowFrames += bytes > 0;
+    windowBytes += bytes;
+    windowAllocations += newAllocations;
+    totalTicks += ticks;
+    totalAllocations += newAllocations;
+
+    if (sampleCount < samples.size()) {
+        Sample& sample = samples[sampleCount++];
+        sample.time = phaseStart;
+        sample.ticks = ticks;
+        sample.bytes = bytes;
+        sample.allocations = newAllocations;
+    }
+
+    if (phaseStart - windowStart >= WINDOW_NANOS) {
+        updateStatusLine();
+        windowStart = phaseStart;
+        memset(windowNanos, 0, sizeof(windowNanos));
+        windowTicks = 0;
+        windowFrames = 0;
+        windowBytes = 0;
+        windowAllocations = 0;
+    }
+}
+
+void FrameProfiler::updateStatusLine() {
+    double ticks = windowTicks > 0 ? windowTicks : 1;
+    snprintf(statusLine, sizeof(statusLine),
+             "ms/tick: input %.3f  sim %.3f  render %.3f  sleep %.1f  |  %lld B/frame  |  "
+             "%.1f allocs/tick   ",
+             windowNanos[PHASE_INPUT] / 1e6 / ticks, windowNanos[PHASE_SIM] / 1e6 / ticks,
+             windowNanos[PHASE_RENDER] / 1e6 / ticks, windowNanos[PHASE_SLEEP] / 1e6 / ticks,
+             windowFrames > 0 ? windowBytes / windowFrames : 0, windowAllocations / ticks);
+}
+
+double FrameProfiler::getMeanMillis(ProfilePhase phase) const {
+    return totalTicks > 0 ? totalNanos[phase] / 1e6 / totalTicks : 0;
+}
+
+double FrameProfiler::getAllocationsPerTick() const {
+    return totalTicks > 0 ? (double)totalAllocations / totalTicks : 0;
+}
+
+bool FrameProfiler::writeTrace(const char* path) const {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+
+    // Phases as complete ("X") events on one thread, per-frame output and
+    // allocations as counter ("C") events; timestamps in microseconds
+    fprintf(out, "{\"traceEvents\": [\n");
+    fprintf(out, "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, "
+                 "\"args\": {\"name\": \"game loop\"}}");
+    for (size_t i = 0; i < spanCount; i++) {
+        const Span& span = spans[i];
+        fprintf(out, ",\n  {\"name\": \"%s\", \"cat\": \"loop\", \"ph\": \"X\", \"ts\": %.3f, "
+                     "\"dur\": %.3f, \"pid\": 1, \"tid\": 1}",
+                PHASE_NAMES[span.phase], (span.start - origin) / 1e3, span.duration / 1e3);
+    }
+    for (size_t i = 0; i < sampleCount; i++) {
+        const Sample& sample = samples[i];
+        fprintf(out, ",\n  {\"name\": \"frame\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, "
+                     "\"args\": {\"ticks\": %d, \"bytes\": %d, \"allocs\": %lld}}",
+                (sample.time - origin) / 1e3, sample.ticks, sample.bytes, sample.allocations);
+    }
+    fprintf(out, "\n], \"displayTimeUnit\": \"ms\", \"otherData\": {\"dropped_spans\": %lld}}\n",
+            droppedSpans);
+    return fclose(out) == 0;
+}
@@ -0,0 +1,111 @@
+// Frame profiler for the interactive game: times each phase of the game
+// loop, counts output bytes and heap allocations per tick, and can show a
+// live status line or export a Chrome trace-event file. While disabled
+// every hook is one predictable branch, so it stays compiled in.
+#ifndef SNAKE_PROFILER_H
+#define SNAKE_PROFILER_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Heap allocations made by the process so far. snake_profiler.cpp
+// replaces the global operator new to count them, so any program linking
+// it gets the counter.
+extern std::atomic<long long> heapAllocations;
+
+// Phases of one pass of the game loop
+enum ProfilePhase {
+    PHASE_INPUT,     // reading keys, or the bot deciding
+    PHASE_SIM,       // GameBoard::step()
+    PHASE_RENDER,    // BoardRenderer::render(), including the write
+    PHASE_SLEEP,     // waiting for the next deadline
+    PHASE_COUNT
+};
+
+class FrameProfiler {
+private:
+    // One timed phase, for the trace
+    struct Span {
+        long long start;
+        long long duration;
+        int phase;
+    };
+
+    // Per-frame counters, for the trace
+    struct Sample {
+        long long time;
+        int ticks;
+        int bytes;
+        long long allocations;
+    };
+
+    bool enabled;
+    int current;                 // phase being timed, -1 before the first mark
+    long long phaseStart;
+    long long origin;            // trace timestamps count from here
+    long long lastAllocations;
+
+    // Window behind the status line, restarted every half second
+    long long windowStart;
+    long long windowNanos[PHASE_COUNT];
+    long long windowTicks;
+    long long windowFrames;
+    long long windowBytes;
+    long long windowAllocations;
+    char statusLine[160];
+
+    long long totalNanos[PHASE_COUNT];
+    long long totalTicks;
+    long long totalAllocations;
+
+    // Trace buffers are sized once by enable(); spans past the end are
+    // counted and dropped rather than growing the buffers mid-game
+    std::vector<Span> spans;
+    std::vector<Sample> samples;
+    size_t spanCount;
+    size_t sampleCount;
+    long long droppedSpans;
+
+    void switchTo(int phase);
+    void closeFrame(int ticks, int bytes);
+    void updateStatusLine();
+
+public:
+    FrameProfiler();
+
+    // Start profiling, keeping room for traceSpans trace spans (0 for
+    // none, when only the status line is wanted)
+    void enable(size_t traceSpans);
+
+    bool isEnabled() const { return enabled; }
+
+    // The previous phase ends and the given one starts
+    void mark(ProfilePhase phase) {
+        if (enabled) switchTo(phase);
+    }
+
+    // End of one loop pass that ran ticks simulation ticks and wrote
+    // bytes of output (0 if nothing was drawn)
+    void endFrame(int ticks, int bytes) {
+        if (enabled) closeFrame(ticks, bytes);
+    }
+
+    // End the current phase without starting another, e.g. while a menu
+    // waits for a key
+    void pause() {
+        if (enabled) switchTo(-1);
+    }
+
+    // Averages over the last window, for drawing under the score line
+    const char* getStatusLine() const { return statusLine; }
+
+    // Mean milliseconds per tick spent in a phase over the whole run
+    double getMeanMillis(ProfilePhase phase) const;
+    double getAllocationsPerTick() const;
+
+    // Write everything recorded as Chrome trace-event JSON
+    bool writeTrace(const char* path) const;
+};
+
+#endif
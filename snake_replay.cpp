@@ -0,0 +1,308 @@
+#include "snake_replay.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace std;
+
+static const char REPLAY_MAGIC[8] = { 'S', 'N', 'K', 'R', 'P', 'L', 'Y', '1' };
+static const uint32_t REPLAY_VERSION = 2;
+
+// Write the parts one after another as the whole file. On POSIX this
+// goes straight to the descriptor, so saving a game does not allocate a
+// stdio buffer.
+static bool writeFile(const char* path, const void* const* parts, const size_t* sizes, int count) {
+    #ifndef _WIN32
+        int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+        bool ok = true;
+        for (int i = 0; i < count && ok; i++) {
+            const uint8_t* p = (const uint8_t*)parts[i];
+            size_t left = sizes[i];
+            while (left > 0) {
+                ssize_t n = ::write(fd, p, left);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    ok = false;
+                    break;
+                }
+                p += n;
+                left -= n;
+            }
+        }
+        return ::close(fd) == 0 && ok;
+    #else
+        FILE* file = fopen(path, "wb");
+        if (!file) return false;
+        bool ok = true;
+        for (int i = 0; i < count && ok; i++) {
+            ok = sizes[i] == 0 || fwrite(parts[i], sizes[i], 1, file) == 1;
+        }
+        return fclose(file) == 0 && ok;
+    #endif
+}
+
+ReplayRecorder::ReplayRecorder(int rows, int cols, uint64_t seed, uint32_t keyframeInterval)
+    : runAction(ACTION_NONE), runLength(0), tick(0) {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    header.version = REPLAY_VERSION;
+    header.rows = rows;
+    header.cols = cols;
+    header.seed = seed;
+    header.keyframeInterval = keyframeInterval > 0 ? keyframeInterval : 1024;
+    actions.reserve(4096);
+}
+
+void ReplayRecorder::reset(uint64_t seed) {
+    header.seed = seed;
+    header.tickCount = 0;
+    header.keyframeCount = 0;
+    actions.clear();
+    states.clear();
+    keyframes.clear();
+    runAction = ACTION_NONE;
+    runLength = 0;
+    tick = 0;
+}
+
+void ReplayRecorder::flushRun() {
+    if (runLength == 0) return;
+
+    if (runLength < 32) {
+        actions.push_back((runAction << 5) | runLength);
+    } else {
+        actions.push_back(runAction << 5);
+        uint64_t n = runLength;
+        while (n >= 0x80) {
+            actions.push_back((n & 0x7F) | 0x80);
+            n >>= 7;
+        }
+        actions.push_back(n);
+    }
+    runLength = 0;
+}
+
+void ReplayRecorder::record(const GameBoard& board, Action action) {
+    bool keyframeDue = tick % header.keyframeInterval == 0;
+    ReplayKeyframe keyframe;
+    if (keyframeDue) {
+        keyframe.tick = tick;
+        keyframe.stateOffset = states.size();
+        board.saveState(states);
+        keyframe.stateSize = states.size() - keyframe.stateOffset;
+    }
+
+    if (runLength > 0 && action != runAction) {
+        flushRun();
+    }
+    runAction = action;
+    runLength++;
+
+    // The run holding this tick is still pending, so it will start at the
+    // current end of the stream
+    if (keyframeDue) {
+        keyframe.runSkip = runLength - 1;
+        keyframe.actionOffset = actions.size();
+        keyframes.push_back(keyframe);
+    }
+    tick++;
+}
+
+bool ReplayRecorder::save(const char* path) {
+    flushRun();
+
+    header.tickCount = tick;
+    header.keyframeCount = keyframes.size();
+    header.actionsOffset = sizeof(ReplayHeader);
+    header.actionsSize = actions.size();
+    uint64_t statesOffset = header.actionsOffset + header.actionsSize;
+    header.indexOffset = statesOffset + states.size();
+
+    // The index holds file offsets; rebase it in place for the write
+    // rather than copy it, and back afterwards
+    for (ReplayKeyframe& keyframe : keyframes) {
+        keyframe.stateOffset += statesOffset;
+    }
+    const void* parts[4] = { &header, actions.data(), states.data(), keyframes.data() };
+    size_t sizes[4] = { sizeof(header), actions.size(), states.size(),
+                        keyframes.size() * sizeof(ReplayKeyframe) };
+    bool ok = writeFile(path, parts, sizes, 4);
+    for (ReplayKeyframe& keyframe : keyframes) {
+        keyframe.stateOffset -= statesOffset;
+    }
+    return ok;
+}
+
+ReplayPlayer::ReplayPlayer()
+    : data(NULL), size(0), mapped(false), header(NULL), keyframes(NULL),
+      cursor(NULL), actionsEnd(NULL), runAction(ACTION_NONE), runLeft(0), tick(0) {}
+
+ReplayPlayer::~ReplayPlayer() {
+    close();
+}
+
+void ReplayPlayer::close() {
+    #ifndef _WIN32
+        if (mapped) munmap((void*)data, size);
+    #endif
+    data = NULL;
+    size = 0;
+    mapped = false;
+    fallback.clear();
+    header = NULL;
+}
+
+bool ReplayPlayer::open(const char* path) {
+    close();
+
+    #ifndef _WIN32
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(ReplayHeader)) {
+            void* view = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED) {
+                data = (const uint8_t*)view;
+                size = info.st_size;
+                mapped = true;
+            }
+        }
+        ::close(fd);
+    #else
+        FILE* file = fopen(path, "rb");
+        if (!file) return false;
+        uint8_t chunk[65536];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            fallback.insert(fallback.end(), chunk, chunk + n);
+        }
+        fclose(file);
+        data = fallback.data();
+        size = fallback.size();
+    #endif
+
+    if (!data || size < sizeof(ReplayHeader)) {
+        close();
+        return false;
+    }
+
+    // Validate before trusting any offsets
+    header = (const ReplayHeader*)data;
+    uint64_t indexBytes = (uint64_t)header->keyframeCount * sizeof(ReplayKeyframe);
+    if (memcmp(header->magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0 ||
+        header->version != REPLAY_VERSION || header->rows < MIN_BOARD_ROWS ||
+        header->cols < MIN_BOARD_COLS || header->rows > 32766 || header->cols > 32766 ||
+        header->actionsOffset > size ||
+        header->actionsSize > size - header->actionsOffset ||
+        header->indexOffset > size || indexBytes > size - header->indexOffset) {
+        close();
+        return false;
+    }
+    keyframes = (const ReplayKeyframe*)(data + header->indexOffset);
+    for (uint32_t i = 0; i < header->keyframeCount; i++) {
+        if (keyframes[i].stateOffset > size ||
+            keyframes[i].stateSize > size - keyframes[i].stateOffset ||
+            keyframes[i].actionOffset > header->actionsSize) {
+            close();
+            return false;
+        }
+    }
+
+    cursor = data + header->actionsOffset;
+    actionsEnd = cursor + header->actionsSize;
+    runLeft = 0;
+    tick = 0;
+    return true;
+}
+
+GameBoard* ReplayPlayer::createBoard() const {
+    return new GameBoard(header->rows, header->cols, header->seed);
+}
+
+// Decode the run header at the cursor
+bool ReplayPlayer::startRun() {
+    if (cursor >= actionsEnd) return false;
+
+    uint8_t byte = *cursor++;
+    runAction = byte >> 5;
+    runLeft = byte & 31;
+    if (runLeft == 0) {
+        int shift = 0;
+        while (cursor < actionsEnd && shift < 64) {
+            uint8_t part = *cursor++;
+            runLeft |= (uint64_t)(part & 0x7F) << shift;
+            shift += 7;
+            if (!(part & 0x80)) break;
+        }
+    }
+    if (runAction > ACTION_RIGHT) runAction = ACTION_NONE;
+    return runLeft > 0;
+}
+
+bool ReplayPlayer::nextAction(Action& action) {
+    if (atEnd()) return false;
+    if (runLeft == 0 && !startRun()) return false;
+
+    action = (Action)runAction;
+    runLeft--;
+    tick++;
+    return true;
+}
+
+bool ReplayPlayer::step(GameBoard& board) {
+    Action action;
+    if (!nextAction(action)) return false;
+    board.step(action);
+    return true;
+}
+
+bool ReplayPlayer::seek(GameBoard& board, uint64_t target) {
+    if (target > header->tickCount) target = header->tickCount;
+
+    // Last keyframe at or before the target
+    int lo = 0;
+    int hi = (int)header->keyframeCount - 1;
+    int found = -1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (keyframes[mid].tick <= target) {
+            found = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    if (found >= 0) {
+        const ReplayKeyframe& keyframe = keyframes[found];
+        if (!board.loadState(data + keyframe.stateOffset, keyframe.stateSize)) {
+            return false;
+        }
+        cursor = data + header->actionsOffset + keyframe.actionOffset;
+        tick = keyframe.tick;
+        runLeft = 0;
+        if (keyframe.runSkip > 0 || tick < header->tickCount) {
+            if (!startRun() || runLeft < keyframe.runSkip) return false;
+            runLeft -= keyframe.runSkip;
+        }
+    } else {
+        // No keyframes: only possible for an empty recording
+        cursor = data + header->actionsOffset;
+        tick = 0;
+        runLeft = 0;
+    }
+
+    while (tick < target) {
+        if (!step(board)) return false;
+    }
+    return true;
+}
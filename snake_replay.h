@@ -0,0 +1,114 @@
+// Deterministic replays. A replay is the board seed and size plus the
+// action taken on every tick, run-length encoded, with periodic keyframe
+// snapshots of the full engine state so a player can seek to any tick
+// without re-simulating from the start.
+//
+// File layout (host byte order):
+//   ReplayHeader | action runs | keyframe state blobs | ReplayKeyframe[]
+//
+// Each action run starts with a byte holding the action in its top three
+// bits and the run length (1-31) in the low five; a length of 0 means the
+// real length follows as a LEB128 varint.
+#ifndef SNAKE_REPLAY_H
+#define SNAKE_REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "snake_engine.h"
+
+struct ReplayHeader {
+    char magic[8];              // "SNKRPLY1"
+    uint32_t version;
+    uint16_t rows;
+    uint16_t cols;
+    uint64_t seed;
+    uint64_t tickCount;
+    uint32_t keyframeInterval;
+    uint32_t keyframeCount;
+    uint64_t actionsOffset;
+    uint64_t actionsSize;
+    uint64_t indexOffset;
+};
+
+struct ReplayKeyframe {
+    uint64_t tick;
+    uint64_t stateOffset;       // from the start of the file
+    uint32_t stateSize;
+    uint32_t runSkip;           // ticks of the run at actionOffset before this one
+    uint64_t actionOffset;      // from the start of the action stream
+};
+
+// Records a game in memory as it is played; save() writes the file.
+// Call record() with the action just before passing it to step().
+class ReplayRecorder {
+private:
+    ReplayHeader header;
+    std::vector<uint8_t> actions;
+    std::vector<uint8_t> states;
+    std::vector<ReplayKeyframe> keyframes;
+    uint8_t runAction;
+    uint64_t runLength;
+    uint64_t tick;
+
+    void flushRun();
+
+public:
+    ReplayRecorder(int rows, int cols, uint64_t seed, uint32_t keyframeInterval = 1024);
+
+    // Start recording a new game on a board of the same size. The buffers
+    // keep their capacity, so the next game records without allocating
+    // until it outgrows the last one.
+    void reset(uint64_t seed);
+
+    void record(const GameBoard& board, Action action);
+    bool save(const char* path);
+
+    uint64_t getTickCount() const { return tick; }
+};
+
+// Plays a replay file back through a GameBoard. The file is mapped into
+// memory, not read, so opening a long replay is cheap.
+class ReplayPlayer {
+private:
+    const uint8_t* data;
+    size_t size;
+    bool mapped;
+    std::vector<uint8_t> fallback;  // file contents where mmap is unavailable
+    const ReplayHeader* header;
+    const ReplayKeyframe* keyframes;
+    const uint8_t* cursor;
+    const uint8_t* actionsEnd;
+    uint8_t runAction;
+    uint64_t runLeft;
+    uint64_t tick;
+
+    bool startRun();
+    void close();
+
+public:
+    ReplayPlayer();
+    ~ReplayPlayer();
+
+    bool open(const char* path);
+
+    const ReplayHeader& getHeader() const { return *header; }
+    uint64_t getTick() const { return tick; }
+    bool atEnd() const { return tick >= header->tickCount; }
+
+    // A new board in the state the recording started from
+    GameBoard* createBoard() const;
+
+    // Bring board to the given tick: restore the nearest keyframe at or
+    // before it, then re-simulate the remaining ticks
+    bool seek(GameBoard& board, uint64_t target);
+
+    // Action for the current tick; false once the recording is exhausted
+    bool nextAction(Action& action);
+
+    // nextAction() followed by board.step()
+    bool step(GameBoard& board);
+};
+
+#endif
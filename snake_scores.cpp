@@ -0,0 +1,463 @@
+#include "snake_scores.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace std;
+
+static const char LOG_MAGIC[8] = { 'S', 'N', 'K', 'S', 'C', 'O', 'R', '1' };
+static const char INDEX_MAGIC[8] = { 'S', 'N', 'K', 'S', 'I', 'D', 'X', '1' };
+static const uint32_t SCORES_VERSION = 1;
+static const uint64_t RECORD_SIZE = sizeof(ScoreRecord);
+static const uint64_t LOG_HEADER_SIZE = sizeof(ScoreLogHeader);
+
+const int ScoreStore::SYNC_BATCH;
+const int ScoreStore::SYNC_MILLIS;
+
+namespace {
+    struct CrcTable {
+        uint32_t entries[256];
+
+        CrcTable() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int bit = 0; bit < 8; bit++) {
+                    c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+                }
+                entries[i] = c;
+            }
+        }
+    };
+}
+
+uint32_t crc32(const void* data, size_t size, uint32_t crc) {
+    static const CrcTable table;
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table.entries[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static uint32_t recordCrc(const ScoreRecord& record) {
+    return crc32(&record.score, RECORD_SIZE - sizeof(record.crc));
+}
+
+static void sealHeader(ScoreLogHeader& header) {
+    header.crc = 0;
+    header.crc = crc32(&header, sizeof(header));
+}
+
+// Ranking: higher score first, then whoever got there first
+static bool ranksAbove(const ScoreRecord& a, const ScoreRecord& b) {
+    if (a.score != b.score) return a.score > b.score;
+    return a.time < b.time;
+}
+
+ScoreStore::ScoreStore(int capacity, uint64_t maxLogBytes)
+    : capacity(max(1, capacity)), maxLogBytes(maxLogBytes), fd(-1), logEnd(0), compactAt(0),
+      pending(0), stopping(false), recoveredBytes(0), skippedRecords(0), syncs(0),
+      compactions(0) {
+    memset(&header, 0, sizeof(header));
+}
+
+ScoreStore::~ScoreStore() {
+    close();
+}
+
+// Place a record on the leaderboard; returns its rank or 0
+int ScoreStore::insert(const ScoreRecord& record) {
+    if ((int)top.size() == capacity && !ranksAbove(record, top.back())) return 0;
+    vector<ScoreRecord>::iterator at = upper_bound(top.begin(), top.end(), record, ranksAbove);
+    int rank = (at - top.begin()) + 1;
+    top.insert(at, record);
+    if ((int)top.size() > capacity) top.pop_back();
+    return rank;
+}
+
+#ifndef _WIN32
+
+// Make a rename in path's directory durable
+static void syncDirectory(const string& path) {
+    size_t slash = path.rfind('/');
+    string dir = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int dirFd = ::open(dir.c_str(), O_RDONLY);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        ::close(dirFd);
+    }
+}
+
+static bool writeAll(int fd, const void* data, size_t size) {
+    const char* p = (const char*)data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool ScoreStore::open(const char* storePath) {
+    close();
+    path = storePath;
+    error.clear();
+    recoveredBytes = 0;
+    skippedRecords = 0;
+
+    int file = ::open(storePath, O_RDWR | O_CREAT, 0644);
+    if (file < 0) {
+        error = "cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    if (flock(file, LOCK_EX | LOCK_NB) != 0) {
+        error = path + " is in use by another process";
+        ::close(file);
+        return false;
+    }
+    // Left behind by a compaction that did not get as far as its rename
+    unlink((path + ".tmp").c_str());
+
+    struct stat info;
+    if (fstat(file, &info) != 0) {
+        error = "cannot stat " + path;
+        ::close(file);
+        return false;
+    }
+    uint64_t fileSize = info.st_size;
+    if (fileSize < LOG_HEADER_SIZE) {
+        // A new store, or one whose creation was cut short
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+        header.version = SCORES_VERSION;
+        header.generation = 1;
+        sealHeader(header);
+        if (pwrite(file, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+            ftruncate(file, sizeof(header)) != 0 || fdatasync(file) != 0) {
+            error = "cannot initialize " + path;
+            ::close(file);
+            return false;
+        }
+        unlink((path + ".idx").c_str());
+        fileSize = LOG_HEADER_SIZE;
+    } else {
+        ScoreLogHeader stored;
+        memset(&stored, 0, sizeof(stored));
+        uint32_t storedCrc = 0;
+        if (pread(file, &stored, sizeof(stored), 0) == (ssize_t)sizeof(stored)) {
+            storedCrc = stored.crc;
+            sealHeader(stored);
+        }
+        if (memcmp(stored.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 ||
+            stored.version != SCORES_VERSION || stored.crc != storedCrc) {
+            error = path + " is not a score log";
+            ::close(file);
+            return false;
+        }
+        header = stored;
+    }
+    fd = file;
+
+    // The index brings back the leaderboard in O(capacity); only records
+    // appended after it was written need replaying
+    top.clear();
+    top.reserve(capacity + 1);
+    uint64_t replayFrom = LOG_HEADER_SIZE;
+    if (!loadIndex(fileSize, replayFrom)) {
+        top.clear();
+        replayFrom = LOG_HEADER_SIZE;
+    }
+    if (!replayLog(replayFrom, fileSize)) {
+        error = "cannot read " + path;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    // Rewrite a stale or missing index soon
+    pending = logEnd > replayFrom || replayFrom == LOG_HEADER_SIZE ? 1 : 0;
+    compactAt = max(maxLogBytes, logEnd + RECORD_SIZE);
+    stopping = false;
+    maintainer = thread(&ScoreStore::runMaintainer, this);
+    return true;
+}
+
+bool ScoreStore::loadIndex(uint64_t fileSize, uint64_t& replayFrom) {
+    int indexFd = ::open((path + ".idx").c_str(), O_RDONLY);
+    if (indexFd < 0) return false;
+    struct stat info;
+    void* view = MAP_FAILED;
+    if (fstat(indexFd, &info) == 0 && info.st_size >= (off_t)sizeof(ScoreIndexHeader)) {
+        view = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, indexFd, 0);
+    }
+    ::close(indexFd);
+    if (view == MAP_FAILED) return false;
+
+    // The index must belong to this log generation, cover no more of the
+    // log than exists, and pass its checksum
+    const ScoreIndexHeader* index = (const ScoreIndexHeader*)view;
+    const ScoreRecord* entries = (const ScoreRecord*)(index + 1);
+    uint64_t size = info.st_size;
+    bool valid = memcmp(index->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+                 index->version == SCORES_VERSION && index->capacity == (uint32_t)capacity &&
+                 index->count <= (uint32_t)capacity &&
+                 size == sizeof(ScoreIndexHeader) + index->count * RECORD_SIZE &&
+                 index->generation == header.generation &&
+                 index->logSize >= LOG_HEADER_SIZE && index->logSize <= fileSize &&
+                 (index->logSize - LOG_HEADER_SIZE) % RECORD_SIZE == 0;
+    if (valid) {
+        ScoreIndexHeader copy = *index;
+        copy.crc = 0;
+        uint32_t crc = crc32(&copy, sizeof(copy));
+        valid = crc32(entries, index->count * RECORD_SIZE, crc) == index->crc;
+    }
+    if (valid) {
+        top.assign(entries, entries + index->count);
+        replayFrom = index->logSize;
+    }
+    munmap(view, size);
+    return valid;
+}
+
+bool ScoreStore::replayLog(uint64_t from, uint64_t fileSize) {
+    static const size_t CHUNK = 1024;
+    vector<ScoreRecord> buffer(CHUNK);
+    uint64_t offset = from;
+    uint64_t validEnd = from;   // just past the last good record
+    long long badRun = 0;       // bad records since then
+    while (offset + RECORD_SIZE <= fileSize) {
+        size_t want = min<uint64_t>(CHUNK, (fileSize - offset) / RECORD_SIZE) * RECORD_SIZE;
+        ssize_t got = pread(fd, buffer.data(), want, offset);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) return false;
+        size_t count = got / RECORD_SIZE;
+        if (count == 0) break;
+        for (size_t i = 0; i < count; i++) {
+            offset += RECORD_SIZE;
+            if (recordCrc(buffer[i]) != buffer[i].crc) {
+                badRun++;
+                continue;
+            }
+            insert(buffer[i]);
+            validEnd = offset;
+            skippedRecords += badRun;
+            badRun = 0;
+        }
+    }
+
+    // A crash can only tear the last writes, so bad or partial records
+    // with nothing good after them are cut off. Bad records with good
+    // ones after them are damage inside the log: they are skipped and
+    // left in place, and nothing valid is ever truncated.
+    if (validEnd < fileSize) {
+        recoveredBytes = fileSize - validEnd;
+        if (ftruncate(fd, validEnd) != 0 || fdatasync(fd) != 0) return false;
+    }
+    logEnd = validEnd;
+    return true;
+}
+
+bool ScoreStore::writeIndex(const vector<ScoreRecord>& entries, uint64_t generation,
+                            uint64_t covered) {
+    ScoreIndexHeader index;
+    memset(&index, 0, sizeof(index));
+    memcpy(index.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    index.version = SCORES_VERSION;
+    index.count = entries.size();
+    index.generation = generation;
+    index.logSize = covered;
+    index.capacity = capacity;
+    index.crc = crc32(entries.data(), entries.size() * RECORD_SIZE, crc32(&index, sizeof(index)));
+
+    // Written aside and renamed over the old one, so a crash leaves one
+    // or the other intact
+    string indexPath = path + ".idx";
+    string tmpPath = indexPath + ".tmp";
+    int out = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) return false;
+    bool ok = writeAll(out, &index, sizeof(index)) &&
+              writeAll(out, entries.data(), entries.size() * RECORD_SIZE) &&
+              fdatasync(out) == 0;
+    ::close(out);
+    if (!ok || rename(tmpPath.c_str(), indexPath.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Rewrite the log as just the leaderboard. The copy is written without
+// the lock held; records appended meanwhile are carried over under it,
+// just before the new file is renamed into place.
+bool ScoreStore::compact(unique_lock<mutex>& lock) {
+    vector<ScoreRecord> keep = top;
+    uint64_t snapshotEnd = logEnd;
+    ScoreLogHeader next = header;
+    next.generation++;
+    next.compactedGames += (snapshotEnd - LOG_HEADER_SIZE) / RECORD_SIZE - keep.size();
+    sealHeader(next);
+    lock.unlock();
+
+    string tmpPath = path + ".tmp";
+    int out = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    bool ok = out >= 0 && writeAll(out, &next, sizeof(next)) &&
+              writeAll(out, keep.data(), keep.size() * RECORD_SIZE) && fdatasync(out) == 0 &&
+              flock(out, LOCK_EX | LOCK_NB) == 0;
+
+    lock.lock();
+    uint64_t tailBytes = logEnd - snapshotEnd;
+    char chunk[64 * RECORD_SIZE];
+    for (uint64_t copied = 0; ok && copied < tailBytes; ) {
+        size_t n = min<uint64_t>(sizeof(chunk), tailBytes - copied);
+        ok = pread(fd, chunk, n, snapshotEnd + copied) == (ssize_t)n && writeAll(out, chunk, n);
+        copied += n;
+    }
+    ok = ok && (tailBytes == 0 || fdatasync(out) == 0) && rename(tmpPath.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        if (out >= 0) ::close(out);
+        unlink(tmpPath.c_str());
+        compactAt = logEnd + maxLogBytes;
+        return false;
+    }
+    syncDirectory(path);
+    ::close(fd);
+    fd = out;
+    header = next;
+    logEnd = LOG_HEADER_SIZE + keep.size() * RECORD_SIZE + tailBytes;
+    compactAt = max(maxLogBytes, logEnd + RECORD_SIZE);
+    compactions++;
+
+    // The old index names the old generation; replace it straight away
+    keep = top;
+    uint64_t covered = logEnd;
+    lock.unlock();
+    writeIndex(keep, next.generation, covered);
+    lock.lock();
+    return true;
+}
+
+// Sync what has been appended, then write an index covering exactly
+// that much; compact if the log has grown too long
+void ScoreStore::maintain(unique_lock<mutex>& lock) {
+    if (pending == 0) return;
+    pending = 0;
+    vector<ScoreRecord> entries = top;
+    uint64_t covered = logEnd;
+    uint64_t generation = header.generation;
+    int file = fd;  // only this thread replaces fd, so it stays valid unlocked
+    lock.unlock();
+
+    bool synced = fdatasync(file) == 0;
+    if (synced) writeIndex(entries, generation, covered);
+
+    lock.lock();
+    syncs++;
+    if (synced && logEnd >= compactAt) compact(lock);
+}
+
+void ScoreStore::runMaintainer() {
+    unique_lock<mutex> lock(stateMutex);
+    while (!stopping) {
+        wake.wait_for(lock, chrono::milliseconds(SYNC_MILLIS),
+                      [this] { return stopping || pending >= SYNC_BATCH; });
+        maintain(lock);
+    }
+    maintain(lock);
+}
+
+void ScoreStore::close() {
+    if (fd < 0) return;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    maintainer.join();
+    ::close(fd);  // also releases the flock
+    fd = -1;
+}
+
+int ScoreStore::record(const char* name, int score, int length, uint32_t ticks) {
+    ScoreRecord record;
+    memset(&record, 0, sizeof(record));
+    record.score = score;
+    record.length = length;
+    record.ticks = ticks;
+    record.time = ::time(NULL);
+    strncpy(record.name, name, sizeof(record.name) - 1);
+    record.crc = recordCrc(record);
+
+    lock_guard<mutex> lock(stateMutex);
+    if (fd < 0) return 0;
+    // A short write is left past logEnd and overwritten by the next record
+    if (pwrite(fd, &record, sizeof(record), logEnd) != (ssize_t)sizeof(record)) {
+        error = "cannot write " + path;
+        return 0;
+    }
+    logEnd += RECORD_SIZE;
+    if (++pending >= SYNC_BATCH) wake.notify_one();
+    return insert(record);
+}
+
+#else
+
+bool ScoreStore::open(const char* storePath) {
+    path = storePath;
+    error = "score store needs POSIX files";
+    return false;
+}
+
+void ScoreStore::close() {}
+
+int ScoreStore::record(const char*, int, int, uint32_t) {
+    return 0;
+}
+
+#endif
+
+vector<ScoreRecord> ScoreStore::getTop(int count) {
+    lock_guard<mutex> lock(stateMutex);
+    count = min(max(count, 0), (int)top.size());
+    return vector<ScoreRecord>(top.begin(), top.begin() + count);
+}
+
+int ScoreStore::getBest() {
+    lock_guard<mutex> lock(stateMutex);
+    return top.empty() ? 0 : top[0].score;
+}
+
+uint64_t ScoreStore::getGames() {
+    lock_guard<mutex> lock(stateMutex);
+    if (logEnd < LOG_HEADER_SIZE) return 0;
+    return header.compactedGames + (logEnd - LOG_HEADER_SIZE) / RECORD_SIZE;
+}
+
+uint64_t ScoreStore::getLogBytes() {
+    lock_guard<mutex> lock(stateMutex);
+    return logEnd;
+}
+
+long long ScoreStore::getSyncs() {
+    lock_guard<mutex> lock(stateMutex);
+    return syncs;
+}
+
+long long ScoreStore::getCompactions() {
+    lock_guard<mutex> lock(stateMutex);
+    return compactions;
+}
@@ -0,0 +1,127 @@
+// Persistent leaderboard. Every finished game is appended to a binary log
+// that is never rewritten in place, and the best games are kept in a
+// small sorted index beside it, so opening the store reads the index and
+// at most the few records written after it rather than the whole history.
+//
+// Files (host byte order):
+//   PATH      ScoreLogHeader | ScoreRecord...    append-only log
+//   PATH.idx  ScoreIndexHeader | ScoreRecord[]   best games, best first
+//
+// Records carry their own CRC-32, so a write torn by a crash or power
+// loss shows up as bad records at the end of the log and is cut off on
+// the next open. A bad record with good ones after it is skipped, never
+// truncated over. A background thread batches the fsyncs, rewrites the
+// index after each one and, once the log passes its size limit, compacts
+// it down to the leaderboard; games dropped that way still count towards
+// getGames().
+#ifndef SNAKE_SCORES_H
+#define SNAKE_SCORES_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ScoreRecord {
+    uint32_t crc;           // CRC-32 of the rest of the record
+    int32_t score;
+    int32_t length;
+    uint32_t ticks;
+    int64_t time;           // Unix seconds
+    char name[16];          // player, NUL-padded
+};
+
+struct ScoreLogHeader {
+    char magic[8];          // "SNKSCOR1"
+    uint32_t version;
+    uint32_t crc;           // CRC-32 of the header with this field zeroed
+    uint64_t generation;    // bumped by every compaction
+    uint64_t compactedGames;  // games compactions have dropped from the log
+};
+
+struct ScoreIndexHeader {
+    char magic[8];          // "SNKSIDX1"
+    uint32_t version;
+    uint32_t count;         // records that follow
+    uint64_t generation;    // log generation the index was built from
+    uint64_t logSize;       // log bytes it covers; later records are replayed
+    uint32_t capacity;      // leaderboard size it was written for
+    uint32_t crc;           // CRC-32 of the header with this field zeroed
+};
+
+// CRC-32 (IEEE 802.3), table driven
+uint32_t crc32(const void* data, size_t size, uint32_t crc = 0);
+
+class ScoreStore {
+private:
+    int capacity;                   // leaderboard size
+    uint64_t maxLogBytes;           // compact once the log is past this
+    std::string path;
+    std::string error;
+    int fd;
+
+    // Shared with the maintenance thread, under stateMutex
+    std::mutex stateMutex;
+    std::condition_variable wake;
+    std::vector<ScoreRecord> top;   // best first, at most capacity
+    ScoreLogHeader header;
+    uint64_t logEnd;                // bytes of valid log
+    uint64_t compactAt;             // log size that triggers the next compaction
+    int pending;                    // records appended since the last sync
+    bool stopping;
+    std::thread maintainer;
+
+    long long recoveredBytes;       // torn tail cut off by open()
+    long long skippedRecords;       // damaged records inside the log, ignored
+    long long syncs;
+    long long compactions;
+
+    int insert(const ScoreRecord& record);
+    bool loadIndex(uint64_t fileSize, uint64_t& replayFrom);
+    bool replayLog(uint64_t from, uint64_t fileSize);
+    bool writeIndex(const std::vector<ScoreRecord>& entries, uint64_t generation,
+                    uint64_t covered);
+    bool compact(std::unique_lock<std::mutex>& lock);
+    void maintain(std::unique_lock<std::mutex>& lock);
+    void runMaintainer();
+
+public:
+    // Records appended before an fsync is forced, and the longest a
+    // record waits for one
+    static const int SYNC_BATCH = 256;
+    static const int SYNC_MILLIS = 1000;
+
+    explicit ScoreStore(int capacity = 100, uint64_t maxLogBytes = 8 << 20);
+    ~ScoreStore();
+
+    // Open or create the store at path. Only one process can have it open;
+    // on failure getError() says why.
+    bool open(const char* path);
+
+    // Sync everything, write the index and stop the maintenance thread
+    void close();
+
+    bool isOpen() const { return fd >= 0; }
+    const std::string& getError() const { return error; }
+
+    // Append a finished game. It reaches the disk with the next batched
+    // fsync; the call itself only writes to the page cache. Returns the
+    // game's leaderboard rank (1 = best) or 0 if it did not make the board.
+    int record(const char* name, int score, int length, uint32_t ticks);
+
+    // Copy of the current leaderboard, best first
+    std::vector<ScoreRecord> getTop(int count);
+
+    int getBest();
+    uint64_t getGames();
+    uint64_t getLogBytes();
+    long long getRecoveredBytes() const { return recoveredBytes; }
+    long long getSkippedRecords() const { return skippedRecords; }
+    long long getSyncs();
+    long long getCompactions();
+};
+
+#endif
@@ -0,0 +1,326 @@
+// Authoritative multiplayer server: one MultiBoard stepped on a fixed tick
+// by a single poll() loop. Each connection is a player. A new player gets
+// a full snapshot; after every tick the delta is encoded once and sent to
+// everyone. Sockets are nonblocking and each client has its own output
+// backlog, so a slow reader never stalls the tick; one that falls too far
+// behind is dropped.
+#include <iostream>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#ifndef _WIN32
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+#include "snake_multi.h"
+#include "snake_net.h"
+
+using namespace std;
+
+#ifndef _WIN32
+
+static const size_t MAX_BACKLOG = 4 << 20;   // bytes queued before a client is dropped
+static const int LATENCY_BUCKETS = 40;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+static long long nowNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Client {
+    int fd;
+    int id;
+    FrameReader in;
+    vector<uint8_t> out;
+    size_t outStart;
+    bool dropped;
+};
+
+// Write as much of data as the socket takes now; false if the client is gone
+static bool writeSome(Client& client, const uint8_t* data, size_t size, size_t& written) {
+    written = 0;
+    while (written < size) {
+        ssize_t n = write(client.fd, data + written, size - written);
+        if (n > 0) {
+            written += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+    return true;
+}
+
+static void flush(Client& client) {
+    if (client.dropped || client.outStart == client.out.size()) return;
+    size_t written;
+    if (!writeSome(client, client.out.data() + client.outStart, client.out.size() - client.outStart, written)) {
+        client.dropped = true;
+        return;
+    }
+    client.outStart += written;
+    if (client.outStart == client.out.size()) {
+        client.out.clear();
+        client.outStart = 0;
+    }
+}
+
+// Send data, queueing whatever the socket will not take yet
+static void send(Client& client, const uint8_t* data, size_t size) {
+    if (client.dropped) return;
+    size_t written = 0;
+    if (client.outStart == client.out.size() && !writeSome(client, data, size, written)) {
+        client.dropped = true;
+        return;
+    }
+    client.out.insert(client.out.end(), data + written, data + size);
+    if (client.out.size() - client.outStart > MAX_BACKLOG) client.dropped = true;
+}
+
+static void readInput(Client& client, MultiBoard& board) {
+    uint8_t buffer[4096];
+    while (true) {
+        ssize_t n = read(client.fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            client.in.append(buffer, n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) client.dropped = true;
+            break;
+        }
+    }
+
+    const uint8_t* payload;
+    uint32_t size;
+    while (client.in.next(payload, size)) {
+        if (size != 2 || payload[0] != MSG_TURN || payload[1] > ACTION_RIGHT) {
+            client.dropped = true;
+            return;
+        }
+        board.setAction(client.id, (Action)payload[1]);
+    }
+}
+
+static void printUsage() {
+    cout << "Usage: snake_server [options]" << endl;
+    cout << "  --listen ADDR     unix:PATH or tcp:PORT (default unix:/tmp/snake.sock)" << endl;
+    cout << "  --rows N          board height (default 100)" << endl;
+    cout << "  --cols N          board width (default 200)" << endl;
+    cout << "  --tick-ms N       time between ticks (default 100)" << endl;
+    cout << "  --max-players N   players on the board at once (default 1024)" << endl;
+    cout << "  --food N          food on the board at once (default 64)" << endl;
+    cout << "  --ticks N         stop after N ticks (default: run until interrupted)" << endl;
+    cout << "  --seed N          board PRNG seed (default 1)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    string address = "unix:/tmp/snake.sock";
+    int rows = 100;
+    int cols = 200;
+    double tickMs = 100;
+    int maxPlayers = 1024;
+    int foodCount = 64;
+    long long maxTicks = 0;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--listen" && hasValue) {
+            address = argv[++i];
+        } else if (arg == "--rows" && hasValue) {
+            rows = atoi(argv[++i]);
+        } else if (arg == "--cols" && hasValue) {
+            cols = atoi(argv[++i]);
+        } else if (arg == "--tick-ms" && hasValue) {
+            tickMs = atof(argv[++i]);
+        } else if (arg == "--max-players" && hasValue) {
+            maxPlayers = atoi(argv[++i]);
+        } else if (arg == "--food" && hasValue) {
+            foodCount = atoi(argv[++i]);
+        } else if (arg == "--ticks" && hasValue) {
+            maxTicks = atoll(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    // Rows and columns go out as u16; owners as 14 bits
+    if (rows < 8 || cols < 8 || rows > 32766 || cols > 32766) {
+        cerr << "Board must be between 8x8 and 32766x32766" << endl;
+        return 1;
+    }
+    if (maxPlayers < 1 || maxPlayers > MultiBoard::MAX_PLAYERS) {
+        cerr << "Players must be between 1 and " << MultiBoard::MAX_PLAYERS << endl;
+        return 1;
+    }
+
+    int listenFd = listenOn(address);
+    if (listenFd < 0 || !setNonBlocking(listenFd)) return 1;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    MultiBoard board(rows, cols, maxPlayers, foodCount, seed);
+    vector<Client> clients;
+    vector<pollfd> fds;
+    vector<uint8_t> message;
+    clients.reserve(maxPlayers);
+    fds.reserve(maxPlayers + 1);
+
+    long long tickNanos = (long long)(tickMs * 1e6);
+    long long nextTick = nowNanos() + tickNanos;
+    long long latencyBuckets[LATENCY_BUCKETS] = {};
+    long long maxLatency = 0;
+    long long lateTicks = 0;
+    long long deltaBytes = 0;
+    long long snapshots = 0;
+    int peakPlayers = 0;
+    cout << "Listening on " << address << " (" << rows << "x" << cols << ", "
+         << tickMs << " ms ticks)" << endl;
+
+    while (!stopRequested && (maxTicks == 0 || board.getTick() < maxTicks)) {
+        fds.clear();
+        fds.push_back({ listenFd, POLLIN, 0 });
+        for (const Client& client : clients) {
+            short events = POLLIN | (client.outStart < client.out.size() ? POLLOUT : 0);
+            fds.push_back({ client.fd, events, 0 });
+        }
+        long long wait = max(0LL, nextTick - nowNanos());
+        if (poll(fds.data(), fds.size(), (int)((wait + 999999) / 1000000)) < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+
+        for (size_t i = 0; i < clients.size(); i++) {
+            Client& client = clients[i];
+            short revents = fds[i + 1].revents;
+            if (revents & (POLLIN | POLLHUP | POLLERR)) readInput(client, board);
+            if (revents & POLLOUT) flush(client);
+        }
+
+        if (fds[0].revents & POLLIN) {
+            while (true) {
+                int fd = accept(listenFd, NULL, NULL);
+                if (fd < 0) break;
+                int id = board.addPlayer();
+                if (id < 0 || !setNonBlocking(fd)) {
+                    close(fd);
+                    continue;
+                }
+                int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                clients.push_back(Client());
+                Client& client = clients.back();
+                client.fd = fd;
+                client.id = id;
+                client.outStart = 0;
+                client.dropped = false;
+                message.clear();
+                encodeSnapshot(board, id, message);
+                send(client, message.data(), message.size());
+                peakPlayers = max(peakPlayers, (int)clients.size());
+            }
+        }
+
+        long long now = nowNanos();
+        if (now >= nextTick) {
+            board.step();
+            // Too many changes to list (mass deaths); resend everything
+            bool overflowed = board.getChanges().hasOverflowed();
+            message.clear();
+            if (!overflowed) {
+                encodeDelta(board, message);
+                deltaBytes += message.size();
+            }
+            for (Client& client : clients) {
+                if (overflowed) {
+                    message.clear();
+                    encodeSnapshot(board, client.id, message);
+                    snapshots++;
+                }
+                send(client, message.data(), message.size());
+            }
+            board.clearChanges();
+
+            long long latency = nowNanos() - now;
+            int bucket = 0;
+            while (bucket < LATENCY_BUCKETS - 1 && (1LL << bucket) < latency) bucket++;
+            latencyBuckets[bucket]++;
+            maxLatency = max(maxLatency, latency);
+
+            nextTick += tickNanos;
+            if (nextTick < nowNanos()) {
+                // Fell a whole tick behind; skip ahead rather than burst
+                lateTicks++;
+                nextTick = nowNanos() + tickNanos;
+            }
+        }
+
+        // Leavers' bodies go out in the next delta
+        for (Client& client : clients) {
+            if (client.dropped) {
+                board.removePlayer(client.id);
+                close(client.fd);
+                client.fd = -1;
+            }
+        }
+        clients.erase(remove_if(clients.begin(), clients.end(),
+                                [](const Client& client) { return client.fd < 0; }),
+                      clients.end());
+    }
+
+    for (const Client& client : clients) {
+        close(client.fd);
+    }
+    close(listenFd);
+
+    long long ticks = board.getTick();
+    auto percentile = [&](double p) {
+        long long wanted = (long long)(p * ticks);
+        long long seen = 0;
+        for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+            seen += latencyBuckets[bucket];
+            if (seen > wanted) return min((double)(1LL << bucket), (double)maxLatency) / 1e3;
+        }
+        return maxLatency / 1e3;
+    };
+    cout << "Ticks:        " << ticks << " (" << lateTicks << " late)" << endl;
+    cout << "Peak players: " << peakPlayers << endl;
+    if (ticks > 0) {
+        cout << "Tick cost:    p50 <= " << percentile(0.5) << " us, p99 <= " << percentile(0.99)
+             << " us, max " << maxLatency / 1e3 << " us" << endl;
+        cout << "Delta size:   " << (double)deltaBytes / ticks << " bytes/tick ("
+             << snapshots << " snapshot resends)" << endl;
+    }
+    return 0;
+}
+
+#else
+
+int main() {
+    cerr << "snake_server needs POSIX sockets" << endl;
+    return 1;
+}
+
+#endif
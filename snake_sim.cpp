@@ -0,0 +1,587 @@
+// Headless driver for the snake engine: plays games back to back with
+// random, scripted or Hamiltonian-cycle actions and reports throughput.
+// Also records and re-simulates replay files, runs the bots, and plays on
+// wraparound and obstacle-map boards.
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <type_traits>
+
+#include "snake_autopilot.h"
+#include "snake_bitboard.h"
+#include "snake_engine.h"
+#include "snake_planner.h"
+#include "snake_replay.h"
+#include "snake_vecenv.h"
+#include "transposition_table.h"
+
+using namespace std;
+
+// Read a script of U/D/L/R/. characters; anything else is ignored
+bool loadScript(const char* path, vector<Action>& script) {
+    ifstream in(path);
+    if (!in) return false;
+
+    char ch;
+    while (in.get(ch)) {
+        switch (toupper(ch)) {
+            case 'U': script.push_back(ACTION_UP); break;
+            case 'D': script.push_back(ACTION_DOWN); break;
+            case 'L': script.push_back(ACTION_LEFT); break;
+            case 'R': script.push_back(ACTION_RIGHT); break;
+            case '.': script.push_back(ACTION_NONE); break;
+        }
+    }
+    return !script.empty();
+}
+
+// Read an obstacle map: one text line per board row, '#' for a wall and
+// anything else for open floor. The board takes the map's size; the
+// border is always a wall, whatever the map has there.
+bool loadMap(const char* path, int& rows, int& cols, vector<Position>& walls) {
+    ifstream in(path);
+    if (!in) return false;
+
+    string line;
+    rows = 0;
+    cols = 0;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        for (int col = 0; col < (int)line.size(); col++) {
+            if (line[col] == '#') walls.push_back(Position(rows, col));
+        }
+        cols = max(cols, (int)line.size());
+        rows++;
+    }
+    return rows > 0;
+}
+
+// Grow the snake every tick along the Hamiltonian cycle and report the
+// average cost of GameBoard::update() per band of snake length
+void runGrowthBenchmark() {
+    // rows / 2 - 1 must be even so the start heading matches the cycle
+    const int sizes[][2] = { {66, 66}, {258, 258} };
+
+    for (const auto& size : sizes) {
+        int rows = size[0];
+        int cols = size[1];
+        int capacity = (rows - 2) * (cols - 2);
+        int band = capacity / 10;
+        GameBoard board(rows, cols, 1);
+
+        cout << "Board " << rows << "x" << cols << endl;
+        cout << "  length      ns/tick" << endl;
+
+        long long ticks = 0;
+        auto bandStart = chrono::steady_clock::now();
+        while (!board.isGameOver() && board.getSnakeLength() < capacity - band) {
+            Snake* snake = board.getSnake();
+            snake->setDirection(cycleDirection(snake->getHead(), rows, cols));
+            snake->grow();
+            board.update();
+
+            if (++ticks % band == 0) {
+                auto now = chrono::steady_clock::now();
+                double ns = chrono::duration<double, nano>(now - bandStart).count();
+                printf("  %8d  %10.1f\n", board.getSnakeLength(), ns / band);
+                bandStart = now;
+            }
+        }
+        cout << endl;
+    }
+}
+
+// Depth-limited lookahead: the most food reachable within depth ticks, or
+// -1 if every line dies. Expanded nodes are counted; with a table, a
+// position already searched to the same depth is not expanded again.
+// Positions are matched by Zobrist hash, which leaves out the food RNG.
+struct Lookahead {
+    vector<GameBoard> boards;    // scratch board per ply
+    TranspositionTable* table;
+    long long expanded;
+
+    Lookahead(int rows, int cols, int depth, TranspositionTable* t)
+        : boards(depth + 1, GameBoard(rows, cols)), table(t), expanded(0) {}
+
+    int search(int ply, int depth) {
+        const GameBoard& board = boards[ply];
+        if (depth == 0) return 0;
+        uint64_t key = board.getHash() ^ splitmix64(depth);
+        uint64_t data;
+        if (table && table->probe(key, data)) return (int)data - 1;
+
+        expanded++;
+        int best = -1;
+        Direction current = board.getSnake()->getDirection();
+        for (int d = 0; d < 4; d++) {
+            if (d == (current ^ 1)) continue;
+            GameBoard& child = boards[ply + 1];
+            child = board;
+            StepResult result = child.step(actionFor((Direction)d));
+            if (result.gameOver) continue;
+            int value = search(ply + 1, depth - 1);
+            if (value >= 0) best = max(best, value + (result.ateFood ? 1 : 0));
+        }
+        if (table) table->store(key, best + 1);
+        return best;
+    }
+};
+
+// Nodes a depth-limited lookahead expands with and without the
+// transposition table, from positions along an autopilot game. Also
+// checks the incremental Zobrist hash against one computed from scratch.
+void runTranspositionBenchmark(int rows, int cols, int depth) {
+    const int positions = 8;
+    GameBoard game(rows, cols, 1);
+    Autopilot autopilot(rows, cols);
+    TranspositionTable table(22);
+    GameBoard fresh(rows, cols);
+    vector<uint8_t> state;
+    long long totalPlain = 0;
+    long long totalCached = 0;
+    bool hashesMatch = true;
+
+    printf("Board %dx%d, depth %d, table %zu entries\n", rows, cols, depth, table.size());
+    printf("  tick  length   plain nodes  cached nodes  reduction  plain ms  cached ms\n");
+    for (int i = 0; i < positions && !game.isGameOver(); i++) {
+        // loadState() rebuilds the snake, so its hash is from scratch
+        state.clear();
+        game.saveState(state);
+        fresh.loadState(state.data(), state.size());
+        hashesMatch = hashesMatch && fresh.getHash() == game.getHash();
+
+        Lookahead plain(rows, cols, depth, NULL);
+        plain.boards[0] = game;
+        auto start = chrono::steady_clock::now();
+        int plainValue = plain.search(0, depth);
+        double plainMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        table.clear();
+        Lookahead cached(rows, cols, depth, &table);
+        cached.boards[0] = game;
+        start = chrono::steady_clock::now();
+        int cachedValue = cached.search(0, depth);
+        double cachedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        printf("  %4d  %6d  %12lld  %12lld  %8.1fx  %8.1f  %9.1f%s\n", i * 25,
+               game.getSnakeLength(), plain.expanded, cached.expanded,
+               (double)plain.expanded / max(1LL, cached.expanded), plainMs, cachedMs,
+               plainValue == cachedValue ? "" : "  (values differ)");
+        totalPlain += plain.expanded;
+        totalCached += cached.expanded;
+
+        for (int t = 0; t < 25 && !game.isGameOver(); t++) {
+            game.step(autopilot.nextAction(game));
+        }
+    }
+    printf("Total: %lld vs %lld nodes (%.1fx fewer)\n", totalPlain, totalCached,
+           (double)totalPlain / max(1LL, totalCached));
+    printf("Incremental hash: %s\n", hashesMatch ? "matches a full rehash" : "MISMATCH");
+}
+
+// Step K boards in lockstep through VectorEnv with the same random policy
+// as the object engine, for a like-for-like throughput comparison
+int runVectorEnv(int boards, int rows, int cols, long long steps, uint64_t seed,
+                 const string& kernelName) {
+    VectorEnv env(boards, rows, cols, seed);
+    if (kernelName == "scalar") env.setKernel(VectorEnv::KERNEL_SCALAR);
+    else if (kernelName == "sse4.1") env.setKernel(VectorEnv::KERNEL_SSE41);
+    else if (kernelName != "avx2" && !kernelName.empty()) {
+        cerr << "Unknown kernel " << kernelName << endl;
+        return 1;
+    }
+
+    Rng actionRng(seed ^ 0xA5A5A5A5A5A5A5A5ULL);
+    vector<uint8_t> actions(boards);
+    long long iterations = (steps + boards - 1) / boards;
+
+    auto start = chrono::steady_clock::now();
+    for (long long it = 0; it < iterations; it++) {
+        for (int i = 0; i < boards; i++) {
+            uint32_t roll = actionRng.nextBelow(16);
+            actions[i] = roll < 4 ? (uint8_t)(ACTION_UP + roll) : (uint8_t)ACTION_NONE;
+        }
+        env.step(actions.data());
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    long long total = iterations * boards;
+
+    printf("Board:        %dx%d x %d boards\n", rows, cols, boards);
+    printf("Kernel:       %s\n", VectorEnv::kernelName(env.getKernel()));
+    printf("Steps:        %lld\n", total);
+    printf("Games ended:  %lld\n", env.getEpisodes());
+    printf("Mean score:   %.2f\n", env.getEpisodes() ? (double)env.getEpisodeScoreSum() / env.getEpisodes() : 0.0);
+    printf("Time:         %.3f s\n", seconds);
+    printf("Steps/sec:    %.0f\n", total / seconds);
+    return 0;
+}
+
+// Re-simulate a replay at full speed. With a seek target, also check that
+// jumping there through the keyframes matches playing every tick.
+int runReplay(const string& path, long long seekTick) {
+    ReplayPlayer player;
+    if (!player.open(path.c_str())) {
+        cerr << "Cannot read replay " << path << endl;
+        return 1;
+    }
+    const ReplayHeader& header = player.getHeader();
+
+    if (seekTick >= 0) {
+        GameBoard* linear = player.createBoard();
+        player.seek(*linear, 0);
+        while (player.getTick() < (uint64_t)seekTick && player.step(*linear)) {}
+
+        GameBoard* seeked = player.createBoard();
+        auto seekStart = chrono::steady_clock::now();
+        bool ok = player.seek(*seeked, seekTick);
+        double seekSeconds = chrono::duration<double>(chrono::steady_clock::now() - seekStart).count();
+
+        vector<uint8_t> expected, actual;
+        linear->saveState(expected);
+        seeked->saveState(actual);
+        bool match = ok && expected == actual;
+        printf("Seek to %lld:  %s in %.3f ms\n", (long long)player.getTick(),
+               match ? "matches linear playback" : "MISMATCH", seekSeconds * 1000.0);
+        delete linear;
+        delete seeked;
+        if (!match) return 1;
+    }
+
+    GameBoard* board = player.createBoard();
+    auto start = chrono::steady_clock::now();
+    player.seek(*board, 0);
+    while (player.step(*board)) {}
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("Board:        %dx%d\n", header.rows, header.cols);
+    printf("Ticks:        %llu (%u keyframes)\n", (unsigned long long)header.tickCount, header.keyframeCount);
+    printf("Final score:  %d%s\n", board->getScore(), board->isGameOver() ? " (game over)" : "");
+    printf("Length:       %d\n", board->getSnakeLength());
+    printf("Time:         %.3f s\n", seconds);
+    delete board;
+    return 0;
+}
+
+// Let a bot (the search autopilot or the MCTS planner) play games to the
+// end: death, a full board, or going twice the board's area without
+// eating, which in the endgame means it is circling its tail for good.
+// Steps cap each game. Reports how it did and what deciding cost.
+int runBot(const string& policy, int rows, int cols, long long steps, uint64_t seed, int games,
+           double budgetMs, int threads) {
+    Autopilot* autopilot = NULL;
+    MctsPlanner* planner = NULL;
+    if (policy == "mcts") {
+        planner = new MctsPlanner(rows, cols, threads, seed);
+    } else {
+        autopilot = new Autopilot(rows, cols);
+    }
+    int capacity = (rows - 2) * (cols - 2);
+    auto start = chrono::steady_clock::now();
+    long long totalTicks = 0;
+
+    printf("Board:        %dx%d\n", rows, cols);
+    printf("Policy:       %s\n", policy.c_str());
+    if (planner) {
+        printf("Planner:      %d threads, %.2f ms per tick\n", planner->getThreadCount(), budgetMs);
+    }
+    for (int game = 0; game < games; game++) {
+        GameBoard board(rows, cols, splitmix64(seed + game));
+        if (autopilot) autopilot->reset();
+        long long ticks = 0;
+        long long hungry = 0;
+        long long stallTicks = 2LL * rows * cols;
+        while (!board.isGameOver() && board.getFoodPosition().row >= 0 && ticks < steps &&
+               hungry < stallTicks) {
+            Action action = planner ? planner->nextAction(board, budgetMs) : autopilot->nextAction(board);
+            hungry = board.step(action).ateFood ? 0 : hungry + 1;
+            ticks++;
+        }
+        totalTicks += ticks;
+
+        const char* outcome = board.isGameOver() ? "died"
+                            : board.getFoodPosition().row < 0 ? "filled the board"
+                            : hungry >= stallTicks ? "stalled" : "step cap";
+        printf("Game %d:       score %d, length %d (%.1f%% of the board), %lld ticks, %s\n",
+               game + 1, board.getScore(), board.getSnakeLength(),
+               100.0 * board.getSnakeLength() / capacity, ticks, outcome);
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (autopilot) {
+        printf("Decisions:    %lld (food %lld, tail %lld, cycle %lld, other %lld)\n",
+               autopilot->getDecisions(), autopilot->getModeCount(Autopilot::MODE_FOOD),
+               autopilot->getModeCount(Autopilot::MODE_TAIL),
+               autopilot->getModeCount(Autopilot::MODE_CYCLE),
+               autopilot->getModeCount(Autopilot::MODE_ANY));
+        printf("Latency:      mean %.2f us, p50 <= %.2f us, p99 <= %.2f us, max %.2f us\n",
+               autopilot->getMeanMicros(), autopilot->getPercentileMicros(50),
+               autopilot->getPercentileMicros(99), autopilot->getMaxMicros());
+    } else {
+        printf("Rollouts:     %lld (%.0f per tick, %.0f/sec)\n", planner->getRollouts(),
+               totalTicks ? (double)planner->getRollouts() / totalTicks : 0.0,
+               planner->getRolloutsPerSecond());
+    }
+    printf("Time:         %.3f s\n", seconds);
+    printf("Ticks/sec:    %.0f\n", totalTicks / seconds);
+    delete autopilot;
+    delete planner;
+    return 0;
+}
+
+struct SimStats {
+    const char* engine;
+    long long games;
+    long long totalScore;
+    int bestLength;
+    double seconds;
+    double bytesPerCell;
+};
+
+// Play games back to back for the given number of steps with one policy.
+// Board is GameBoard or a BitboardBoard chosen by dispatchBoard(), or a
+// TorusBoard or ObstacleBoard; walls only apply to the last.
+template <typename Board>
+SimStats simulate(int rows, int cols, long long steps, uint64_t seed, const string& policyName,
+                  const vector<Action>& script, const string& recordPath,
+                  const vector<Position>& walls) {
+    enum { RANDOM, CYCLE, SCRIPT } policy =
+        policyName == "random" ? RANDOM : policyName == "cycle" ? CYCLE : SCRIPT;
+    Rng actionRng(seed ^ 0xA5A5A5A5A5A5A5A5ULL);
+    SimStats stats = { Board::engineName(), 0, 0, 0, 0, 0 };
+    size_t scriptPos = 0;
+
+    Board* board = new Board(rows, cols, splitmix64(seed));
+    if constexpr (is_same<Board, ObstacleBoard>::value) {
+        // Walls stay put through every reset
+        for (const Position& wall : walls) {
+            board->addWall(wall);
+        }
+    }
+    ReplayRecorder* recorder = NULL;
+    if (!recordPath.empty()) {
+        recorder = new ReplayRecorder(rows, cols, splitmix64(seed));
+    }
+    auto start = chrono::steady_clock::now();
+
+    for (long long step = 0; step < steps; step++) {
+        Action action = ACTION_NONE;
+        if (policy == RANDOM) {
+            // Turn on roughly one step in four so games last a while
+            uint32_t roll = actionRng.nextBelow(16);
+            if (roll < 4) action = (Action)(ACTION_UP + roll);
+        } else if (policy == CYCLE) {
+            action = actionFor(cycleDirection(board->getHead(), rows, cols));
+        } else {
+            action = script[scriptPos];
+            if (++scriptPos == script.size()) scriptPos = 0;
+        }
+
+        if constexpr (is_same<Board, GameBoard>::value) {
+            if (recorder) recorder->record(*board, action);
+        }
+        if (board->step(action).gameOver) {
+            if (recorder) {
+                if (!recorder->save(recordPath.c_str())) {
+                    cerr << "Could not write " << recordPath << endl;
+                }
+                delete recorder;
+                recorder = NULL;
+            }
+            stats.games++;
+            stats.totalScore += board->getScore();
+            stats.bestLength = max(stats.bestLength, board->getSnakeLength());
+            board->reset(splitmix64(seed + stats.games));
+        }
+    }
+
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    stats.bytesPerCell = (double)board->getMemoryUsage() / ((double)rows * cols);
+    delete board;
+    if (recorder) {
+        // Game still running when the step budget ran out
+        if (!recorder->save(recordPath.c_str())) {
+            cerr << "Could not write " << recordPath << endl;
+        }
+        delete recorder;
+    }
+    return stats;
+}
+
+void printUsage() {
+    cout << "Usage: snake_sim [options]" << endl;
+    cout << "  --rows N          board rows (default 20)" << endl;
+    cout << "  --cols N          board columns (default 40)" << endl;
+    cout << "  --steps N         total steps to simulate (default 10000000)" << endl;
+    cout << "  --seed N          master seed (default 1)" << endl;
+    cout << "  --policy NAME     random | cycle | autopilot | mcts (default random)" << endl;
+    cout << "  --games N         with a bot policy, games to play to the end (default 1)" << endl;
+    cout << "  --budget-ms MS    mcts search time per tick (default 5)" << endl;
+    cout << "  --threads N       mcts worker threads (default: all cores)" << endl;
+    cout << "  --script FILE     replay U/D/L/R/. actions from FILE in a loop" << endl;
+    cout << "  --vec K           step K boards in lockstep with the SoA vector env" << endl;
+    cout << "  --kernel NAME     vector env kernel: avx2 | sse4.1 | scalar" << endl;
+    cout << "  --engine NAME     auto | generic (auto picks a bitboard engine for" << endl;
+    cout << "                    10x10, 20x20, 20x40, 22x40, 32x32 and 64x64)" << endl;
+    cout << "  --topology NAME   bounded | torus | obstacles (default bounded)" << endl;
+    cout << "  --map FILE        obstacle map, '#' for walls; sets the board size" << endl;
+    cout << "                    and implies --topology obstacles" << endl;
+    cout << "  --record FILE     save the first game as a replay" << endl;
+    cout << "  --replay FILE     re-simulate a replay at full speed" << endl;
+    cout << "  --seek T          with --replay, verify a keyframe seek to tick T" << endl;
+    cout << "  --bench-growth    per-tick cost as the snake grows" << endl;
+    cout << "  --bench-tt D      nodes a depth-D lookahead expands with and without" << endl;
+    cout << "                    the transposition table (on --rows x --cols)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    int rows = 20;
+    int cols = 40;
+    long long steps = 10000000;
+    uint64_t seed = 1;
+    string policy = "random";
+    vector<Action> script;
+    int vecBoards = 0;
+    string kernelName;
+    string recordPath;
+    string replayPath;
+    long long seekTick = -1;
+    bool generic = false;
+    string topology = "bounded";
+    vector<Position> walls;
+    int botGames = 1;
+    int benchDepth = 0;
+    double budgetMs = 5;
+    int threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--rows" && hasValue) {
+            rows = atoi(argv[++i]);
+        } else if (arg == "--cols" && hasValue) {
+            cols = atoi(argv[++i]);
+        } else if (arg == "--steps" && hasValue) {
+            steps = atoll(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (arg == "--policy" && hasValue) {
+            policy = argv[++i];
+        } else if (arg == "--games" && hasValue) {
+            botGames = atoi(argv[++i]);
+        } else if (arg == "--budget-ms" && hasValue) {
+            budgetMs = atof(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if (arg == "--script" && hasValue) {
+            if (!loadScript(argv[++i], script)) {
+                cerr << "Could not read a script from " << argv[i] << endl;
+                return 1;
+            }
+            policy = "script";
+        } else if (arg == "--vec" && hasValue) {
+            vecBoards = atoi(argv[++i]);
+        } else if (arg == "--kernel" && hasValue) {
+            kernelName = argv[++i];
+        } else if (arg == "--engine" && hasValue) {
+            string name = argv[++i];
+            if (name != "auto" && name != "generic") {
+                printUsage();
+                return 1;
+            }
+            generic = name == "generic";
+        } else if (arg == "--topology" && hasValue) {
+            topology = argv[++i];
+            if (topology != "bounded" && topology != "torus" && topology != "obstacles") {
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--map" && hasValue) {
+            if (!loadMap(argv[++i], rows, cols, walls)) {
+                cerr << "Could not read a map from " << argv[i] << endl;
+                return 1;
+            }
+            topology = "obstacles";
+        } else if (arg == "--record" && hasValue) {
+            recordPath = argv[++i];
+        } else if (arg == "--replay" && hasValue) {
+            replayPath = argv[++i];
+        } else if (arg == "--seek" && hasValue) {
+            seekTick = atoll(argv[++i]);
+        } else if (arg == "--bench-growth") {
+            runGrowthBenchmark();
+            return 0;
+        } else if (arg == "--bench-tt" && hasValue) {
+            benchDepth = atoi(argv[++i]);
+        } else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (!replayPath.empty()) {
+        return runReplay(replayPath, seekTick);
+    }
+    if (benchDepth > 0) {
+        runTranspositionBenchmark(rows, cols, benchDepth);
+        return 0;
+    }
+    if (rows < MIN_BOARD_ROWS || cols < MIN_BOARD_COLS || rows > 32766 || cols > 32766) {
+        cerr << "Board must be between 4x6 and 32766x32766" << endl;
+        return 1;
+    }
+    if (topology != "bounded" && (vecBoards > 0 || !recordPath.empty() ||
+                                  policy == "autopilot" || policy == "mcts")) {
+        cerr << "--vec, --record and the bots only run on bounded boards" << endl;
+        return 1;
+    }
+    if (vecBoards > 0) {
+        return runVectorEnv(vecBoards, rows, cols, steps, seed, kernelName);
+    }
+    if (policy == "autopilot" || policy == "mcts") {
+        return runBot(policy, rows, cols, steps, seed, botGames, budgetMs, threads);
+    }
+    if (policy == "cycle" && (rows % 2 != 0 || (rows / 2 - 1) % 2 != 0)) {
+        cerr << "The cycle policy needs rows / 2 - 1 even (e.g. 22, 26, 66)" << endl;
+        return 1;
+    }
+    if (policy != "random" && policy != "cycle" && policy != "script") {
+        printUsage();
+        return 1;
+    }
+
+    // Replays are written from GameBoard snapshots, so recording always
+    // runs on the generic engine. The bitboard engines are bounded only.
+    SimStats stats;
+    if (topology == "torus") {
+        stats = simulate<TorusBoard>(rows, cols, steps, seed, policy, script, recordPath, walls);
+    } else if (topology == "obstacles") {
+        stats = simulate<ObstacleBoard>(rows, cols, steps, seed, policy, script, recordPath, walls);
+    } else if (generic || !recordPath.empty()) {
+        stats = simulate<GameBoard>(rows, cols, steps, seed, policy, script, recordPath, walls);
+    } else {
+        stats = dispatchBoard(rows, cols, [&](auto* type) {
+            typedef remove_pointer_t<decltype(type)> Board;
+            return simulate<Board>(rows, cols, steps, seed, policy, script, recordPath, walls);
+        });
+    }
+    long long games = stats.games;
+    double seconds = stats.seconds;
+
+    printf("Board:        %dx%d\n", rows, cols);
+    printf("Engine:       %s\n", stats.engine);
+    printf("Policy:       %s\n", policy.c_str());
+    printf("Steps:        %lld\n", steps);
+    printf("Games ended:  %lld\n", games);
+    printf("Mean score:   %.2f\n", games ? (double)stats.totalScore / games : 0.0);
+    printf("Best length:  %d\n", stats.bestLength);
+    printf("Board memory: %.3f bytes/cell\n", stats.bytesPerCell);
+    printf("Time:         %.3f s\n", seconds);
+    printf("Steps/sec:    %.0f\n", steps / seconds);
+    return 0;
+}
@@ -0,0 +1,885 @@
+#include "snake_terminal.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+// Platform-specific headers
+#ifdef _WIN32
+    #include <conio.h>
+    #include <windows.h>
+#else
+    #include <unistd.h>
+    #include <cerrno>
+    #include <poll.h>
+    #include <sys/ioctl.h>
+    #ifdef __linux__
+        #include <sys/timerfd.h>
+    #endif
+#endif
+
+using namespace std;
+
+// Utility function to clear screen (only called once at start)
+void clearScreen() {
+    #ifdef _WIN32
+        system("cls");
+    #else
+        system("clear");
+    #endif
+}
+
+// Set cursor position to avoid flickering
+void setCursorPosition(int x, int y) {
+    #ifdef _WIN32
+        COORD coord;
+        coord.X = x;
+        coord.Y = y;
+        SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), coord);
+    #else
+        printf("\033[%d;%dH", y + 1, x + 1);
+        fflush(stdout);
+    #endif
+}
+
+// Hide cursor to avoid flickering
+void hideCursor() {
+    #ifdef _WIN32
+        HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
+        CONSOLE_CURSOR_INFO info;
+        info.dwSize = 100;
+        info.bVisible = FALSE;
+        SetConsoleCursorInfo(consoleHandle, &info);
+    #else
+        printf("\e[?25l");
+        fflush(stdout);
+    #endif
+}
+
+// Show cursor
+void showCursor() {
+    #ifdef _WIN32
+        HANDLE consoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
+        CONSOLE_CURSOR_INFO info;
+        info.dwSize = 100;
+        info.bVisible = TRUE;
+        SetConsoleCursorInfo(consoleHandle, &info);
+    #else
+        printf("\e[?25h");
+        fflush(stdout);
+    #endif
+}
+
+void terminalSize(int& rows, int& cols, int fd) {
+    rows = 24;
+    cols = 80;
+    #ifdef _WIN32
+        (void)fd;
+        CONSOLE_SCREEN_BUFFER_INFO info;
+        if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+            rows = info.srWindow.Bottom - info.srWindow.Top + 1;
+            cols = info.srWindow.Right - info.srWindow.Left + 1;
+        }
+    #else
+        struct winsize size;
+        if (ioctl(fd, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0) {
+            rows = size.ws_row;
+            cols = size.ws_col;
+        }
+    #endif
+}
+
+long long monotonicNanos() {
+    #ifdef _WIN32
+        static LARGE_INTEGER frequency = {};
+        if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return (long long)((double)counter.QuadPart * 1e9 / frequency.QuadPart);
+    #else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    #endif
+}
+
+void sleepUntil(long long deadline) {
+    #ifdef _WIN32
+        long long remaining = deadline - monotonicNanos();
+        if (remaining > 0) Sleep((DWORD)(remaining / 1000000));
+    #elif defined(__APPLE__)
+        long long remaining = deadline - monotonicNanos();
+        if (remaining > 0) {
+            struct timespec ts = { (time_t)(remaining / 1000000000LL), (long)(remaining % 1000000000LL) };
+            nanosleep(&ts, NULL);
+        }
+    #else
+        struct timespec ts = { (time_t)(deadline / 1000000000LL), (long)(deadline % 1000000000LL) };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+    #endif
+}
+
+TickScheduler::TickScheduler(int tickMs, int renderMs, int maxCatchUpTicks)
+    : tickPeriod(tickMs * 1000000LL), renderPeriod(renderMs * 1000000LL),
+      maxCatchUp(maxCatchUpTicks), nextTick(0), nextRender(0), lastWake(0),
+      ticks(0), droppedTicks(0), tickWakes(0), maxJitter(0), jitterSum(0), jitterSumSquares(0) {}
+
+void TickScheduler::start() {
+    ticks = 0;
+    droppedTicks = 0;
+    tickWakes = 0;
+    maxJitter = 0;
+    jitterSum = 0;
+    jitterSumSquares = 0;
+    lastWake = monotonicNanos();
+    nextTick = lastWake + tickPeriod;
+    nextRender = lastWake;
+}
+
+int TickScheduler::waitForWork() {
+    sleepUntil(getNextDeadline());
+    return collectDueTicks();
+}
+
+int TickScheduler::collectDueTicks() {
+    lastWake = monotonicNanos();
+
+    if (lastWake < nextTick) {
+        return 0;
+    }
+
+    long long late = lastWake - nextTick;
+    if (late > maxJitter) maxJitter = late;
+    tickWakes++;
+    jitterSum += late;
+    jitterSumSquares += (double)late * late;
+
+    int due = 1 + late / tickPeriod;
+    if (due > maxCatchUp) {
+        droppedTicks += due - maxCatchUp;
+        due = maxCatchUp;
+        nextTick = lastWake + tickPeriod;
+    } else {
+        nextTick += due * tickPeriod;
+    }
+    ticks += due;
+    return due;
+}
+
+bool TickScheduler::renderDue() {
+    if (lastWake < nextRender) {
+        return false;
+    }
+    nextRender += renderPeriod;
+    if (nextRender <= lastWake) {
+        nextRender = lastWake + renderPeriod;
+    }
+    return true;
+}
+
+double TickScheduler::getMeanJitterMs() const {
+    return tickWakes ? jitterSum / tickWakes / 1e6 : 0;
+}
+
+double TickScheduler::getJitterStdDevMs() const {
+    if (tickWakes == 0) return 0;
+    double mean = jitterSum / tickWakes;
+    double variance = jitterSumSquares / tickWakes - mean * mean;
+    return variance > 0 ? sqrt(variance) / 1e6 : 0;
+}
+
+FrameComposer::FrameComposer(bool syncUpdates, int outputFd)
+    : synchronized(syncUpdates), output(outputFd), lastBytes(0), lastWrites(0),
+      frames(0), totalBytes(0), totalWrites(0), cursorRow(-1), cursorCol(0), screenCols(1 << 30),
+      terminal(false), sampleTime(0), sampledQueue(0), bytesSinceSample(0), drainRate(0) {
+    buffer.reserve(4096);
+    #ifndef _WIN32
+        terminal = isatty(output);
+    #endif
+    #ifdef _WIN32
+        // Let the console interpret the ANSI sequences written below
+        HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        GetConsoleMode(out, &mode);
+        SetConsoleMode(out, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    #endif
+}
+
+void FrameComposer::appendNumber(long long value) {
+    char digits[24];
+    int n = 0;
+    bool negative = value < 0;
+    unsigned long long v = negative ? -(unsigned long long)value : value;
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v > 0);
+    if (negative) buffer += '-';
+    while (n > 0) buffer += digits[--n];
+    cursorRow = -1;
+}
+
+static int digitCount(int value) {
+    int n = 1;
+    while (value >= 10) {
+        value /= 10;
+        n++;
+    }
+    return n;
+}
+
+// Bytes in ESC [ n X, where n is left out when it is 1
+static int motionCost(int count) {
+    count = abs(count);
+    return count == 0 ? 0 : count == 1 ? 3 : 3 + digitCount(count);
+}
+
+void FrameComposer::appendMotion(int count, char command) {
+    buffer += "\033[";
+    if (count > 1) appendNumber(count);
+    buffer += command;
+}
+
+void FrameComposer::moveTo(int x, int y) {
+    if (cursorRow == y && cursorCol == x) return;
+
+    // ESC [ row ; col H, leaving out a column of 1
+    int absoluteCost = 3 + digitCount(y + 1) + (x > 0 ? 1 + digitCount(x + 1) : 0);
+
+    // From a known position: up/down, then a carriage return, a
+    // left/right move or ESC [ col G, whichever is shortest
+    int relativeCost = absoluteCost;
+    char horizontal = 0;
+    if (cursorRow >= 0) {
+        int dx = x - cursorCol;
+        relativeCost = motionCost(y - cursorRow);
+        if (dx != 0) {
+            int stepCost = motionCost(dx);
+            int columnCost = x > 0 ? 3 + digitCount(x + 1) : 3;
+            if (x == 0) {
+                horizontal = '\r';
+                relativeCost += 1;
+            } else if (stepCost <= columnCost) {
+                horizontal = dx > 0 ? 'C' : 'D';
+                relativeCost += stepCost;
+            } else {
+                horizontal = 'G';
+                relativeCost += columnCost;
+            }
+        }
+    }
+
+    if (relativeCost < absoluteCost) {
+        int dy = y - cursorRow;
+        if (dy != 0) appendMotion(abs(dy), dy > 0 ? 'B' : 'A');
+        if (horizontal == '\r') {
+            buffer += '\r';
+        } else if (horizontal == 'G') {
+            appendMotion(x + 1, 'G');
+        } else if (horizontal) {
+            appendMotion(abs(x - cursorCol), horizontal);
+        }
+    } else {
+        buffer += "\033[";
+        if (y > 0 || x > 0) appendNumber(y + 1);
+        if (x > 0) {
+            buffer += ';';
+            appendNumber(x + 1);
+        }
+        buffer += 'H';
+    }
+    cursorRow = y;
+    cursorCol = x;
+}
+
+bool FrameComposer::isBacklogged(long long maxLatency) {
+    #if !defined(_WIN32) && defined(TIOCOUTQ)
+        int queued = 0;
+        if (!terminal || ioctl(output, TIOCOUTQ, &queued) != 0) return false;
+
+        // Pseudo-terminals always report an empty queue; all that shows
+        // there is the buffer filling up, so also skip while a write would
+        // block
+        struct pollfd pfd = { output, POLLOUT, 0 };
+        if (queued == 0 && poll(&pfd, 1, 0) == 0) return true;
+
+        // While the queue stays non-empty the terminal drains as fast as it
+        // can, so what left it since the last sample gives the rate
+        long long now = monotonicNanos();
+        if (sampledQueue > 0 && queued > 0 && now > sampleTime) {
+            long long drained = sampledQueue + bytesSinceSample - queued;
+            if (drained > 0) {
+                double rate = (double)drained / (now - sampleTime);
+                drainRate = drainRate > 0 ? drainRate * 0.75 + rate * 0.25 : rate;
+            }
+        }
+        sampleTime = now;
+        sampledQueue = queued;
+        bytesSinceSample = 0;
+
+        if (queued == 0) return false;
+        if (drainRate <= 0) return queued > lastBytes;
+        return queued / drainRate > maxLatency;
+    #else
+        (void)maxLatency;
+        return false;
+    #endif
+}
+
+void FrameComposer::flush() {
+    // Nothing changed: skip the write rather than send empty escapes
+    if (buffer.size() == (synchronized ? sizeof("\033[?2026h") - 1 : 0)) {
+        lastBytes = 0;
+        lastWrites = 0;
+        return;
+    }
+    if (synchronized) buffer += "\033[?2026l";
+
+    int writes = 0;
+    #ifdef _WIN32
+        DWORD written = 0;
+        WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), buffer.data(), buffer.size(), &written, NULL);
+        writes = 1;
+    #else
+        // One write(2) unless the terminal takes a partial write
+        size_t offset = 0;
+        while (offset < buffer.size()) {
+            ssize_t n = write(output, buffer.data() + offset, buffer.size() - offset);
+            writes++;
+            if (n < 0) {
+                if (errno == EINTR || errno == EAGAIN) continue;
+                break;
+            }
+            offset += n;
+        }
+    #endif
+
+    lastBytes = buffer.size();
+    lastWrites = writes;
+    bytesSinceSample += lastBytes;
+    frames++;
+    totalBytes += lastBytes;
+    totalWrites += writes;
+}
+
+void TextLine::update(FrameComposer& composer, int row, const char* text) {
+    int length = strlen(text);
+    int width = max(length, (int)shown.size());
+    for (int i = 0; i < width; i++) {
+        char want = i < length ? text[i] : ' ';
+        char have = i < (int)shown.size() ? shown[i] : ' ';
+        if (want == have) continue;
+
+        // Overwriting a short unchanged gap is cheaper than a cursor move
+        int from = composer.getCursorCol();
+        if (composer.getCursorRow() == row && from < i && i - from <= 3) {
+            for (int k = from; k < i; k++) composer.put(k < length ? text[k] : ' ');
+        } else {
+            composer.moveTo(i, row);
+        }
+        composer.put(want);
+    }
+    shown.assign(text, length);
+}
+
+// Append text or a number at p and return the new end; for building the
+// score line without snprintf on every frame
+static char* appendText(char* p, const char* text) {
+    while (*text) *p++ = *text++;
+    return p;
+}
+
+static char* appendInt(char* p, int value) {
+    char digits[12];
+    int n = 0;
+    unsigned v = value < 0 ? -(unsigned)value : value;
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v > 0);
+    if (value < 0) *p++ = '-';
+    while (n > 0) *p++ = digits[--n];
+    return p;
+}
+
+void ScoreLines::draw(FrameComposer& composer, int viewRows, int score, int highScore,
+                      int length, const char* statusLine) {
+    char* p = appendText(line, "Score: ");
+    p = appendInt(p, score);
+    p = appendText(p, "  |  High Score: ");
+    p = appendInt(p, highScore);
+    p = appendText(p, "  |  Length: ");
+    p = appendInt(p, length);
+    *p = '\0';
+    scoreText.update(composer, viewRows, line);
+    if (statusLine) {
+        statusText.update(composer, viewRows + 2, statusLine);
+    }
+}
+
+// Write a glyph at (c, r) of the viewport, whose row on screen currently
+// shows shownRow. Up to three unchanged cells after the cursor are cheaper
+// to write again than to skip with a cursor move.
+static void drawGlyph(FrameComposer& composer, const char* shownRow, int r, int c, char glyph) {
+    int from = composer.getCursorCol();
+    if (composer.getCursorRow() == r && from < c && c - from <= 3) {
+        for (int k = from; k < c; k++) composer.put(shownRow[k]);
+    } else {
+        composer.moveTo(c, r);
+    }
+    composer.put(glyph);
+}
+
+char BoardRenderer::glyphFor(const GameBoard& board, CellKind kind) const {
+    switch (kind) {
+        case CELL_HEAD: return board.getSnake()->getHeadSymbol();
+        case CELL_BODY: return board.getSnake()->getBodySymbol();
+        case CELL_FOOD: return board.getFood()->getSymbol();
+        default:        return ' ';
+    }
+}
+
+char BoardRenderer::glyphAt(const GameBoard& board, Position pos) const {
+    bool edgeRow = pos.row == 0 || pos.row == board.getRows() - 1;
+    bool edgeCol = pos.col == 0 || pos.col == board.getCols() - 1;
+    if (edgeRow) return edgeCol ? '+' : '=';
+    if (edgeCol) return '|';
+    return glyphFor(board, board.cellAt(pos));
+}
+
+bool BoardRenderer::followHead(const GameBoard& board) {
+    int rows = board.getRows();
+    int cols = board.getCols();
+    Position head = board.getSnake()->getHead();
+    int top = viewTop;
+    int left = viewLeft;
+
+    // Recentre once the head is within a quarter view of an edge
+    int rowMargin = viewRows / 4;
+    int colMargin = viewCols / 4;
+    if (head.row < top + rowMargin || head.row >= top + viewRows - rowMargin) {
+        top = head.row - viewRows / 2;
+    }
+    if (head.col < left + colMargin || head.col >= left + viewCols - colMargin) {
+        left = head.col - viewCols / 2;
+    }
+    top = max(0, min(top, rows - viewRows));
+    left = max(0, min(left, cols - viewCols));
+
+    bool moved = top != viewTop || left != viewLeft;
+    viewTop = top;
+    viewLeft = left;
+    return moved;
+}
+
+void BoardRenderer::drawCell(int r, int c, char glyph) {
+    size_t row = (size_t)r * viewCols;
+    drawGlyph(composer, &shown[row], r, c, glyph);
+    shown[row + c] = glyph;
+}
+
+void BoardRenderer::paintViewport(const GameBoard& board) {
+    // Only cells whose glyph differs from the screen, so a scroll over
+    // mostly empty board writes little
+    for (int r = 0; r < viewRows; r++) {
+        for (int c = 0; c < viewCols; c++) {
+            char glyph = glyphAt(board, Position(viewTop + r, viewLeft + c));
+            if (glyph != shown[(size_t)r * viewCols + c]) drawCell(r, c, glyph);
+        }
+    }
+}
+
+void BoardRenderer::renderInitial(const GameBoard& board) {
+    // Fit the viewport to the terminal, leaving the status lines
+    int screenRows, screenCols;
+    terminalSize(screenRows, screenCols, composer.getOutput());
+    viewRows = max(3, min(board.getRows(), screenRows - (statusLine ? 3 : 2)));
+    viewCols = max(3, min(board.getCols(), screenCols));
+    viewTop = 0;
+    viewLeft = 0;
+    followHead(board);
+
+    // Clear the screen and hide the cursor as part of the same write; the
+    // board is then drawn over the blank screen
+    composer.setScreenWidth(screenCols);
+    composer.begin();
+    composer.text("\033[?25l");
+    composer.clearScreen();
+    shown.assign((size_t)viewRows * viewCols, ' ');
+    dirty.reserve(256);
+    skippedFrames = 0;
+    scoreLines.reset();
+    paintViewport(board);
+    scoreLines.draw(composer, viewRows, board.getScore(), board.getHighScore(),
+                    board.getSnakeLength(), statusLine);
+    composer.moveTo(0, viewRows + 1);
+    composer.text("Controls: W/A/S/D or Arrow Keys  |  P: Autopilot  |  Q: Quit");
+    composer.flush();
+}
+
+void BoardRenderer::render(GameBoard& board) {
+    CellChangeList& changes = board.getChanges();
+
+    // If the terminal is still behind, skip this frame; its changes stay
+    // in the list and go out with the next one
+    if (composer.isBacklogged(maxLatency)) {
+        skippedFrames++;
+        return;
+    }
+
+    // Draw only the visible cells the simulation reported as changed, in
+    // screen order and only where the glyph differs from the screen;
+    // repaint the view if it scrolled or the change list overflowed
+    composer.begin();
+    bool moved = followHead(board);
+    if (moved || changes.hasOverflowed()) {
+        paintViewport(board);
+    } else {
+        dirty.clear();
+        for (int i = 0; i < changes.size(); i++) {
+            const CellChange& change = changes[i];
+            int r = change.pos.row - viewTop;
+            int c = change.pos.col - viewLeft;
+            if (r < 0 || r >= viewRows || c < 0 || c >= viewCols) continue;
+            dirty.push_back(r * viewCols + c);
+        }
+        sort(dirty.begin(), dirty.end());
+        for (int cell : dirty) {
+            int r = cell / viewCols;
+            int c = cell % viewCols;
+            char glyph = glyphAt(board, Position(viewTop + r, viewLeft + c));
+            if (glyph != shown[cell]) drawCell(r, c, glyph);
+        }
+    }
+    changes.clear();
+
+    scoreLines.draw(composer, viewRows, board.getScore(), board.getHighScore(),
+                    board.getSnakeLength(), statusLine);
+    composer.flush();
+}
+
+void BoardRenderer::captureView(GameBoard& board, vector<char>& cells) {
+    CellChangeList& changes = board.getChanges();
+    bool moved = followHead(board);
+    size_t size = (size_t)viewRows * viewCols;
+    if (moved || changes.hasOverflowed() || cells.size() != size) {
+        cells.resize(size);
+        for (int r = 0; r < viewRows; r++) {
+            for (int c = 0; c < viewCols; c++) {
+                cells[(size_t)r * viewCols + c] = glyphAt(board, Position(viewTop + r, viewLeft + c));
+            }
+        }
+    } else {
+        for (int i = 0; i < changes.size(); i++) {
+            const CellChange& change = changes[i];
+            int r = change.pos.row - viewTop;
+            int c = change.pos.col - viewLeft;
+            if (r < 0 || r >= viewRows || c < 0 || c >= viewCols) continue;
+            // By position, not kind, so a head that died on the border
+            // leaves the border glyph as render() does
+            cells[(size_t)r * viewCols + c] = glyphAt(board, change.pos);
+        }
+    }
+    changes.clear();
+}
+
+RenderThread::RenderThread(int renderMs, int outputFd)
+    : composer(true, outputFd), viewRows(0), viewCols(0), renderPeriod(renderMs * 1000000LL),
+      active(false), exiting(false), stopping(false), published(0), dropped(0), drawnFrames(0),
+      skippedFrames(0) {}
+
+RenderThread::~RenderThread() {
+    stop();
+    if (!thread.joinable()) return;
+    {
+        lock_guard<mutex> guard(stateMutex);
+        exiting = true;
+    }
+    wake.notify_all();
+    thread.join();
+}
+
+void RenderThread::start(BoardRenderer& renderer, GameBoard& board) {
+    viewRows = renderer.getViewRows();
+    viewCols = renderer.getViewCols();
+    int screenRows, screenCols;
+    terminalSize(screenRows, screenCols, composer.getOutput());
+    composer.setScreenWidth(screenCols);
+
+    // The screen was cleared and redrawn by the renderer since the last
+    // game, and a frame that game published is still waiting
+    composer.forgetCursor();
+    scoreLines.reset();
+    frames.acquire();
+    published.store(0, memory_order_relaxed);
+    dropped.store(0, memory_order_relaxed);
+    drawnFrames.store(0, memory_order_relaxed);
+    skippedFrames.store(0, memory_order_relaxed);
+
+    // The screen already shows the board, so start from the same glyphs
+    renderer.captureView(board, view);
+    drawn = view;
+    stopping.store(false);
+    {
+        lock_guard<mutex> guard(stateMutex);
+        active = true;
+    }
+    if (thread.joinable()) {
+        wake.notify_all();
+    } else {
+        thread = std::thread(&RenderThread::loop, this);
+    }
+}
+
+void RenderThread::publish(BoardRenderer& renderer, GameBoard& board) {
+    renderer.captureView(board, view);
+
+    // Copying into a slot of the same size reuses its buffer
+    FrameSnapshot& frame = frames.getBack();
+    frame.cells = view;
+    frame.score = board.getScore();
+    frame.highScore = board.getHighScore();
+    frame.length = board.getSnakeLength();
+    const char* status = renderer.getStatusLine();
+    if (status) {
+        strncpy(frame.statusLine, status, sizeof(frame.statusLine) - 1);
+        frame.statusLine[sizeof(frame.statusLine) - 1] = '\0';
+    } else {
+        frame.statusLine[0] = '\0';
+    }
+
+    published.fetch_add(1, memory_order_relaxed);
+    if (frames.publish()) {
+        dropped.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+void RenderThread::stop() {
+    unique_lock<mutex> lock(stateMutex);
+    if (!active) return;
+    stopping.store(true, memory_order_release);
+    wake.wait(lock, [this] { return !active; });
+}
+
+void RenderThread::loop() {
+    // Parked between games; drawFrames() runs while one is on
+    unique_lock<mutex> lock(stateMutex);
+    for (;;) {
+        wake.wait(lock, [this] { return active || exiting; });
+        if (exiting) return;
+        lock.unlock();
+        drawFrames();
+        lock.lock();
+        active = false;
+        wake.notify_all();
+    }
+}
+
+void RenderThread::drawFrames() {
+    long long next = monotonicNanos();
+    while (!stopping.load(memory_order_acquire)) {
+        // While the terminal is behind, leave frames in the buffer; the
+        // newest one is drawn once it has caught up
+        if (composer.isBacklogged(renderPeriod)) {
+            skippedFrames.fetch_add(1, memory_order_relaxed);
+        } else if (frames.acquire()) {
+            draw(frames.getFront());
+            drawnFrames.fetch_add(1, memory_order_relaxed);
+        }
+        long long now = monotonicNanos();
+        next += renderPeriod;
+        if (next <= now) next = now + renderPeriod;
+        sleepUntil(next);
+    }
+}
+
+void RenderThread::draw(const FrameSnapshot& frame) {
+    // Write the cells that differ from the screen, skipping unchanged rows
+    // with one compare
+    composer.begin();
+    for (int r = 0; r < viewRows; r++) {
+        size_t row = (size_t)r * viewCols;
+        if (memcmp(&frame.cells[row], &drawn[row], viewCols) == 0) continue;
+        for (int c = 0; c < viewCols; c++) {
+            char glyph = frame.cells[row + c];
+            if (glyph == drawn[row + c]) continue;
+            drawGlyph(composer, &drawn[row], r, c, glyph);
+            drawn[row + c] = glyph;
+        }
+    }
+    scoreLines.draw(composer, viewRows, frame.score, frame.highScore, frame.length,
+                    frame.statusLine[0] ? frame.statusLine : NULL);
+    composer.flush();
+}
+
+// Bytes worth queueing: printable ones plus Enter. Ctrl+A..Ctrl+D would
+// otherwise read as the arrow keys (their codes are 1-4), and a NUL as
+// KEY_NONE.
+static bool isKeyByte(unsigned char ch) {
+    return ch >= 0x20 || ch == '\r' || ch == '\n';
+}
+
+InputHandler::InputHandler() {
+    #ifndef _WIN32
+        inputClosed = false;
+        escapeState = 0;
+        rawMode = tcgetattr(STDIN_FILENO, &oldSettings) == 0;
+        if (rawMode) {
+            struct termios newSettings = oldSettings;
+            newSettings.c_lflag &= ~(ICANON | ECHO);
+            newSettings.c_cc[VMIN] = 1;
+            newSettings.c_cc[VTIME] = 0;
+            tcsetattr(STDIN_FILENO, TCSANOW, &newSettings);
+        }
+        #ifdef __linux__
+            timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+        #else
+            timerFd = -1;
+        #endif
+    #endif
+}
+
+InputHandler::~InputHandler() {
+    cleanup();
+    #ifndef _WIN32
+        if (timerFd >= 0) close(timerFd);
+    #endif
+}
+
+#ifndef _WIN32
+void InputHandler::parse(const char* bytes, int count) {
+    for (int i = 0; i < count; i++) {
+        char ch = bytes[i];
+        if (escapeState == 1) {
+            escapeState = (ch == '[' || ch == 'O') ? 2 : 0;
+            if (escapeState == 2) continue;
+        } else if (escapeState == 2) {
+            escapeState = 0;
+            switch (ch) {
+                case 'A': queue.push(KEY_UP); break;
+                case 'B': queue.push(KEY_DOWN); break;
+                case 'C': queue.push(KEY_RIGHT); break;
+                case 'D': queue.push(KEY_LEFT); break;
+            }
+            continue;
+        }
+
+        if (ch == 27) {
+            escapeState = 1;
+        } else if (isKeyByte(ch)) {
+            queue.push(toupper((unsigned char)ch));
+        }
+    }
+}
+
+void InputHandler::drainInput() {
+    char bytes[64];
+    struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+    while (!inputClosed && poll(&pfd, 1, 0) > 0) {
+        ssize_t n = read(STDIN_FILENO, bytes, sizeof(bytes));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            inputClosed = true;
+            break;
+        }
+        parse(bytes, n);
+    }
+}
+#else
+void InputHandler::drainInput() {
+    while (_kbhit()) {
+        int key = _getch();
+        if (key == 0xE0 || key == 0) {  // Arrow key prefix
+            switch (_getch()) {
+                case 72: queue.push(KEY_UP); break;
+                case 80: queue.push(KEY_DOWN); break;
+                case 75: queue.push(KEY_LEFT); break;
+                case 77: queue.push(KEY_RIGHT); break;
+            }
+        } else if (isKeyByte(key)) {
+            queue.push(toupper(key));
+        }
+    }
+}
+#endif
+
+void InputHandler::waitUntil(long long deadline) {
+    #ifdef _WIN32
+        HANDLE in = GetStdHandle(STD_INPUT_HANDLE);
+        long long remaining;
+        while ((remaining = deadline - monotonicNanos()) > 0) {
+            WaitForSingleObject(in, (DWORD)((remaining + 999999) / 1000000));
+            drainInput();
+        }
+    #else
+        #ifdef __linux__
+        if (timerFd >= 0) {
+            struct itimerspec spec = {};
+            spec.it_value.tv_sec = deadline / 1000000000LL;
+            spec.it_value.tv_nsec = deadline % 1000000000LL;
+            timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, NULL);
+
+            struct pollfd fds[2] = { { timerFd, POLLIN, 0 }, { STDIN_FILENO, POLLIN, 0 } };
+            while (true) {
+                int ready = poll(fds, inputClosed ? 1 : 2, -1);
+                if (ready < 0) {
+                    if (errno == EINTR) continue;
+                    break;
+                }
+                if (fds[1].revents) {
+                    drainInput();
+                }
+                if (fds[0].revents & POLLIN) {
+                    uint64_t expirations;
+                    ssize_t n = read(timerFd, &expirations, sizeof(expirations));
+                    (void)n;
+                    break;
+                }
+            }
+            return;
+        }
+        #endif
+
+        // No timerfd: poll stdin with a millisecond timeout instead
+        long long remaining;
+        while ((remaining = deadline - monotonicNanos()) > 0) {
+            struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+            int timeoutMs = (int)((remaining + 999999) / 1000000);
+            if (poll(&pfd, inputClosed ? 0 : 1, timeoutMs) > 0) {
+                drainInput();
+            }
+        }
+    #endif
+}
+
+char InputHandler::waitForKey() {
+    drainInput();
+    while (queue.empty()) {
+        #ifdef _WIN32
+            WaitForSingleObject(GetStdHandle(STD_INPUT_HANDLE), INFINITE);
+        #else
+            if (inputClosed) return 'Q';
+            struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+            if (poll(&pfd, 1, -1) < 0) {
+                // A signal: let the caller check whatever its handler set
+                if (errno == EINTR) return KEY_NONE;
+                return 'Q';
+            }
+        #endif
+        drainInput();
+    }
+    return queue.pop();
+}
+
+void InputHandler::cleanup() {
+    #ifndef _WIN32
+        if (rawMode) {
+            tcsetattr(STDIN_FILENO, TCSANOW, &oldSettings);
+        }
+    #endif
+}
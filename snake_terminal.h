@@ -0,0 +1,473 @@
+// Terminal frontend support: screen control, frame composition, timing
+// and keyboard input. Everything that touches stdin/stdout lives here so
+// the engine in snake_engine.h stays headless.
+#ifndef SNAKE_TERMINAL_H
+#define SNAKE_TERMINAL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+    #include <termios.h>
+#endif
+
+#include "snake_engine.h"
+
+// Screen control
+void clearScreen();
+void setCursorPosition(int x, int y);
+void hideCursor();
+void showCursor();
+
+// Size of the terminal on the given descriptor (POSIX; the Windows console
+// is always queried); 24x80 if it is not a terminal
+void terminalSize(int& rows, int& cols, int fd = 1);
+
+// Current time on a monotonic clock, in nanoseconds
+long long monotonicNanos();
+
+// Sleep until an absolute monotonic deadline
+void sleepUntil(long long deadline);
+
+// Fixed-timestep scheduler. Simulation ticks fall on absolute deadlines so
+// time spent rendering or polling input does not stretch the tick period,
+// and rendering runs on its own period. If the loop falls behind it runs
+// the missed ticks, up to maxCatchUp per wake-up, then drops the rest.
+class TickScheduler {
+private:
+    long long tickPeriod;
+    long long renderPeriod;
+    int maxCatchUp;
+    long long nextTick;
+    long long nextRender;
+    long long lastWake;
+
+    // How late each wake-up was relative to its tick deadline
+    long long ticks;
+    long long droppedTicks;
+    long long tickWakes;
+    long long maxJitter;
+    double jitterSum;
+    double jitterSumSquares;
+
+public:
+    TickScheduler(int tickMs, int renderMs, int maxCatchUpTicks = 5);
+
+    // Begin a run from now; the statistics start over, so one scheduler
+    // can be reused for every game
+    void start();
+
+    // Earliest tick or render deadline
+    long long getNextDeadline() const {
+        return nextTick < nextRender ? nextTick : nextRender;
+    }
+
+    // Sleep until the next deadline and return how many ticks are due
+    int waitForWork();
+
+    // Called after waking up: how many simulation ticks are due (zero
+    // when only a render is due)
+    int collectDueTicks();
+
+    // True once per render period, checked after the due ticks have run
+    bool renderDue();
+
+    long long getTicks() const { return ticks; }
+    long long getDroppedTicks() const { return droppedTicks; }
+    double getMaxJitterMs() const { return maxJitter / 1e6; }
+    double getMeanJitterMs() const;
+    double getJitterStdDevMs() const;
+};
+
+// Collects everything a frame draws (cursor moves, glyphs, score line)
+// in one reusable buffer and sends it to the terminal with a single write.
+// Optionally wraps the frame in synchronized-update escapes so terminals
+// that support them present it atomically. Frames go to stdout unless
+// another file descriptor is given (POSIX only; benchmarks pass
+// /dev/null).
+//
+// The composer tracks where the cursor is, across frames, so moveTo()
+// can send the shortest motion: nothing, a carriage return, a relative
+// move or an absolute one. put() and glyph() advance the tracked cursor;
+// text() and appendNumber() make it unknown until the next moveTo().
+class FrameComposer {
+private:
+    std::string buffer;
+    bool synchronized;
+    int output;
+    int lastBytes;
+    int lastWrites;
+    long long frames;
+    long long totalBytes;
+    long long totalWrites;
+    int cursorRow;      // -1 if unknown
+    int cursorCol;
+    int screenCols;     // the cursor is unknown after writing the last column
+    bool terminal;      // output is a terminal, so its queue can be sampled
+
+    // Output queue sampling, for estimating how fast the terminal drains
+    long long sampleTime;
+    int sampledQueue;
+    long long bytesSinceSample;
+    double drainRate;   // bytes per nanosecond, 0 until measured
+
+    void advance(int columns) {
+        cursorCol += columns;
+        if (cursorCol >= screenCols) cursorRow = -1;
+    }
+
+    void appendMotion(int count, char command);
+
+public:
+    FrameComposer(bool syncUpdates = true, int outputFd = 1);
+
+    void begin() {
+        buffer.clear();
+        if (synchronized) buffer += "\033[?2026h";
+    }
+
+    void moveTo(int x, int y);
+
+    void put(char c) {
+        buffer += c;
+        advance(1);
+    }
+
+    // Multi-byte glyph that takes up the given number of columns
+    void glyph(const char* bytes, int columns) {
+        buffer += bytes;
+        advance(columns);
+    }
+
+    void text(const char* str) {
+        buffer += str;
+        cursorRow = -1;
+    }
+
+    // Clear the screen and home the cursor
+    void clearScreen() {
+        buffer += "\033[2J\033[H";
+        cursorRow = 0;
+        cursorCol = 0;
+    }
+
+    void appendNumber(long long value);
+    void flush();
+
+    // Terminal width; 0 if not known
+    void setScreenWidth(int cols) {
+        screenCols = cols > 0 ? cols : 1 << 30;
+    }
+
+    int getCursorRow() const { return cursorRow; }
+    int getCursorCol() const { return cursorCol; }
+
+    // Something else wrote to the terminal; the next moveTo() is absolute
+    void forgetCursor() {
+        cursorRow = -1;
+    }
+
+    // True when the terminal still has more output queued than it can
+    // drain within maxLatency nanoseconds (POSIX terminals that report
+    // their queue; never otherwise). Drawing another frame then would
+    // only add latency, so renderers skip it and merge its changes into
+    // the next one.
+    bool isBacklogged(long long maxLatency);
+
+    int getOutput() const { return output; }
+    double getDrainRate() const { return drainRate * 1e9; }
+    int getLastBytes() const { return lastBytes; }
+    int getLastWrites() const { return lastWrites; }
+    double getAverageBytes() const { return frames ? (double)totalBytes / frames : 0; }
+    double getAverageWrites() const { return frames ? (double)totalWrites / frames : 0; }
+};
+
+// A line of text that stays on screen. update() rewrites only the
+// characters that differ from what the line shows, so a score going from
+// 120 to 130 costs a cursor move and one digit.
+class TextLine {
+private:
+    std::string shown;
+
+public:
+    // The screen was cleared; the line is blank
+    void reset() {
+        shown.clear();
+    }
+
+    void update(FrameComposer& composer, int row, const char* text);
+};
+
+// The score line under the viewport and the optional status line below
+// the controls
+class ScoreLines {
+private:
+    TextLine scoreText;
+    TextLine statusText;
+    char line[96];
+
+public:
+    void reset() {
+        scoreText.reset();
+        statusText.reset();
+    }
+
+    void draw(FrameComposer& composer, int viewRows, int score, int highScore, int length,
+              const char* statusLine);
+};
+
+// Draws a GameBoard through a viewport the size of the terminal (or the
+// board, if smaller) that follows the head. A frame draws only the changed
+// cells that are visible; when the head nears the edge the viewport is
+// recentred and repainted, so frame cost depends on the terminal size,
+// never on the board size.
+class BoardRenderer {
+private:
+    FrameComposer composer;
+    int viewTop;
+    int viewLeft;
+    int viewRows;
+    int viewCols;
+    const char* statusLine;   // extra line under the controls, if set
+    std::vector<char> shown;  // glyphs on screen, viewRows x viewCols
+    std::vector<int> dirty;   // visible cells to redraw this frame
+    ScoreLines scoreLines;
+    long long maxLatency;
+    long long skippedFrames;
+
+    char glyphFor(const GameBoard& board, CellKind kind) const;
+    char glyphAt(const GameBoard& board, Position pos) const;
+
+    // Move the viewport if the head is too close to its edge
+    bool followHead(const GameBoard& board);
+    void paintViewport(const GameBoard& board);
+    void drawCell(int r, int c, char glyph);
+
+public:
+    BoardRenderer(int outputFd = 1)
+        : composer(true, outputFd), viewTop(0), viewLeft(0), viewRows(0), viewCols(0),
+          statusLine(NULL), maxLatency(100000000LL), skippedFrames(0) {}
+
+    // Skip frames while the terminal needs longer than this to drain
+    // what is already queued
+    void setMaxLatency(int ms) {
+        maxLatency = ms * 1000000LL;
+    }
+
+    // Redraw this text under the controls every frame (e.g. profiler
+    // stats); set before renderInitial() so the viewport leaves room
+    void setStatusLine(const char* text) {
+        statusLine = text;
+    }
+
+    void renderInitial(const GameBoard& board);
+    void render(GameBoard& board);
+
+    // Instead of drawing, bring a copy of the visible glyphs (row-major,
+    // getViewRows() x getViewCols()) up to date with the board, scrolling
+    // the viewport as render() would. For drawing on another thread.
+    void captureView(GameBoard& board, std::vector<char>& cells);
+
+    const FrameComposer& getComposer() const { return composer; }
+    const char* getStatusLine() const { return statusLine; }
+    long long getSkippedFrames() const { return skippedFrames; }
+    int getViewRows() const { return viewRows; }
+    int getViewCols() const { return viewCols; }
+};
+
+// One frame for the render thread: the visible glyphs and status values
+struct FrameSnapshot {
+    std::vector<char> cells;
+    int score;
+    int highScore;
+    int length;
+    char statusLine[160];   // empty if there is none
+};
+
+// Lock-free single-producer single-consumer triple buffer. The producer
+// fills its back slot and swaps it into the middle; the consumer swaps the
+// middle out only if it is newer than what it has. A frame the consumer
+// never picked up is overwritten, so a slow consumer sees only the latest
+// frame and the producer never waits.
+class TripleBuffer {
+private:
+    static const int FRESH = 4;  // middle holds a frame not yet consumed
+
+    FrameSnapshot slots[3];
+    std::atomic<int> middle;     // slot index, plus FRESH
+    int back;                    // producer's slot
+    int front;                   // consumer's slot
+
+public:
+    TripleBuffer() : middle(1), back(0), front(2) {}
+
+    FrameSnapshot& getBack() { return slots[back]; }
+    const FrameSnapshot& getFront() const { return slots[front]; }
+
+    // Hand the back slot over; true if that replaced an unconsumed frame
+    bool publish() {
+        int old = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+        back = old & 3;
+        return (old & FRESH) != 0;
+    }
+
+    // Take the newest frame into the front slot; false if there is none
+    bool acquire() {
+        if (!(middle.load(std::memory_order_acquire) & FRESH)) return false;
+        int old = middle.exchange(front, std::memory_order_acq_rel);
+        front = old & 3;
+        return true;
+    }
+};
+
+// Draws frames on its own thread so a slow terminal never delays the
+// simulation or input. The game thread publishes a snapshot of the
+// viewport after its ticks; once per render period the render thread takes
+// the newest one, writes the cells that differ from what it last drew and
+// drops any frames it never got to.
+//
+// The thread is created by the first start() and parked by stop(), so a
+// restarted game draws on the same thread with the same buffers.
+class RenderThread {
+private:
+    TripleBuffer frames;
+    FrameComposer composer;
+    std::vector<char> view;    // game thread's copy of the visible glyphs
+    std::vector<char> drawn;   // what the terminal shows, render thread only
+    ScoreLines scoreLines;
+    int viewRows;
+    int viewCols;
+    long long renderPeriod;
+    std::thread thread;
+    std::mutex stateMutex;
+    std::condition_variable wake;
+    bool active;               // drawing a game; guarded by stateMutex
+    bool exiting;              // guarded by stateMutex
+    std::atomic<bool> stopping;
+    std::atomic<long long> published;
+    std::atomic<long long> dropped;
+    std::atomic<long long> drawnFrames;
+    std::atomic<long long> skippedFrames;
+
+    void loop();
+    void drawFrames();
+    void draw(const FrameSnapshot& frame);
+
+public:
+    RenderThread(int renderMs, int outputFd = 1);
+    ~RenderThread();
+
+    // Start drawing a game; the renderer has already drawn the board with
+    // renderInitial() and keeps choosing the viewport. The frame counts
+    // start again from zero.
+    void start(BoardRenderer& renderer, GameBoard& board);
+
+    // Game thread: snapshot the board for the next frame
+    void publish(BoardRenderer& renderer, GameBoard& board);
+
+    // Stop drawing and wait until the render thread has parked, so
+    // nothing it writes lands on what the game shows next
+    void stop();
+
+    long long getPublished() const { return published.load(std::memory_order_relaxed); }
+    long long getDropped() const { return dropped.load(std::memory_order_relaxed); }
+    long long getDrawn() const { return drawnFrames.load(std::memory_order_relaxed); }
+    long long getSkipped() const { return skippedFrames.load(std::memory_order_relaxed); }
+    const FrameComposer& getComposer() const { return composer; }
+};
+
+// Key codes for the arrow keys; letters are reported as upper case. Other
+// control characters than Enter never reach the queue, so these codes
+// only ever mean an arrow key.
+enum Key {
+    KEY_NONE = 0,
+    KEY_UP = 1,
+    KEY_DOWN = 2,
+    KEY_LEFT = 3,
+    KEY_RIGHT = 4
+};
+
+// Single-producer single-consumer ring of key codes. The input layer
+// pushes every key it parses and the game pops them once per tick, so
+// keys pressed between ticks are kept instead of dropped.
+class KeyQueue {
+private:
+    static const unsigned CAPACITY = 32;  // power of two
+    char keys[CAPACITY];
+    std::atomic<unsigned> head;  // next slot to pop
+    std::atomic<unsigned> tail;  // next slot to push
+
+public:
+    KeyQueue() : head(0), tail(0) {}
+
+    bool push(char key) {
+        unsigned t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == CAPACITY) {
+            return false;  // full, drop the key
+        }
+        keys[t & (CAPACITY - 1)] = key;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    char pop() {
+        unsigned h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return KEY_NONE;
+        }
+        char key = keys[h & (CAPACITY - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return key;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
+
+// InputHandler class. The terminal is put in raw mode once for the life
+// of the handler. Waiting blocks in poll() on stdin plus a timerfd armed
+// with the caller's deadline, so the game sleeps until a key arrives or
+// the next tick is due; idle screens block with no timeout at all.
+class InputHandler {
+private:
+    KeyQueue queue;
+    #ifndef _WIN32
+        struct termios oldSettings;
+        bool rawMode;
+        bool inputClosed;
+        int timerFd;
+        int escapeState;  // 0 normal, 1 after ESC, 2 after ESC [ or ESC O
+
+        // Turn raw bytes into key codes, keeping escape state across reads
+        void parse(const char* bytes, int count);
+    #endif
+
+    // Read whatever stdin has ready without blocking
+    void drainInput();
+
+public:
+    InputHandler();
+    ~InputHandler();
+
+    // Block until the monotonic deadline, queueing any keys that arrive
+    void waitUntil(long long deadline);
+
+    // Block until a key is available and return it; KEY_NONE if a signal
+    // interrupted the wait
+    char waitForKey();
+
+    // Next queued key, or KEY_NONE if the queue is empty
+    char popKey() {
+        drainInput();
+        return queue.pop();
+    }
+
+    void cleanup();
+};
+
+#endif
@@ -0,0 +1,328 @@
+#include "snake_vecenv.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #include <immintrin.h>
+    #define SNAKE_X86_KERNELS 1
+#endif
+
+using namespace std;
+
+// Movement kernel: apply actions (no reversing; bytes past ACTION_RIGHT
+// count as ACTION_NONE), move every head one cell and flag wall hits and
+// food hits. Directions are UP=0, DOWN=1,
+// LEFT=2, RIGHT=3, so the reverse of d is d ^ 1 and the deltas are
+// row += 2d - 1 for d < 2 and col += 2d - 5 otherwise.
+typedef void (*MoveKernel)(int from, int to, const uint8_t* actions, int32_t* dir,
+                           int32_t* headRow, int32_t* headCol,
+                           const int32_t* foodRow, const int32_t* foodCol,
+                           int rows, int cols, int32_t* flags);
+
+static void moveScalar(int from, int to, const uint8_t* actions, int32_t* dir,
+                       int32_t* headRow, int32_t* headCol,
+                       const int32_t* foodRow, const int32_t* foodCol,
+                       int rows, int cols, int32_t* flags) {
+    for (int i = from; i < to; i++) {
+        int32_t a = actions[i];
+        int32_t d = dir[i];
+        if (a >= ACTION_UP && a <= ACTION_RIGHT && a - 1 != (d ^ 1)) d = a - 1;
+        dir[i] = d;
+
+        int32_t r = headRow[i] + (d < 2 ? 2 * d - 1 : 0);
+        int32_t c = headCol[i] + (d < 2 ? 0 : 2 * d - 5);
+        headRow[i] = r;
+        headCol[i] = c;
+
+        int32_t wall = r <= 0 || r >= rows - 1 || c <= 0 || c >= cols - 1;
+        int32_t food = r == foodRow[i] && c == foodCol[i];
+        flags[i] = wall * VectorEnv::FLAG_WALL | food * VectorEnv::FLAG_FOOD;
+    }
+}
+
+#ifdef SNAKE_X86_KERNELS
+__attribute__((target("sse4.1")))
+static void moveSse41(int from, int to, const uint8_t* actions, int32_t* dir,
+                      int32_t* headRow, int32_t* headCol,
+                      const int32_t* foodRow, const int32_t* foodCol,
+                      int rows, int cols, int32_t* flags) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+    const __m128i four = _mm_set1_epi32(ACTION_RIGHT);
+    const __m128i five = _mm_set1_epi32(5);
+    const __m128i lastRow = _mm_set1_epi32(rows - 2);
+    const __m128i lastCol = _mm_set1_epi32(cols - 2);
+    const __m128i wallBit = _mm_set1_epi32(VectorEnv::FLAG_WALL);
+    const __m128i foodBit = _mm_set1_epi32(VectorEnv::FLAG_FOOD);
+
+    int i = from;
+    for (; i + 4 <= to; i += 4) {
+        int32_t packed;
+        memcpy(&packed, actions + i, 4);
+        __m128i a = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dir + i));
+
+        __m128i wanted = _mm_sub_epi32(a, one);
+        __m128i reject = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(a, zero), _mm_cmpgt_epi32(a, four)),
+            _mm_cmpeq_epi32(wanted, _mm_xor_si128(d, one)));
+        d = _mm_blendv_epi8(wanted, d, reject);
+        _mm_storeu_si128((__m128i*)(dir + i), d);
+
+        __m128i vertical = _mm_cmplt_epi32(d, two);
+        __m128i twiceD = _mm_add_epi32(d, d);
+        __m128i dRow = _mm_and_si128(vertical, _mm_sub_epi32(twiceD, one));
+        __m128i dCol = _mm_andnot_si128(vertical, _mm_sub_epi32(twiceD, five));
+        __m128i r = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(headRow + i)), dRow);
+        __m128i c = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(headCol + i)), dCol);
+        _mm_storeu_si128((__m128i*)(headRow + i), r);
+        _mm_storeu_si128((__m128i*)(headCol + i), c);
+
+        __m128i wall = _mm_or_si128(
+            _mm_or_si128(_mm_cmplt_epi32(r, one), _mm_cmpgt_epi32(r, lastRow)),
+            _mm_or_si128(_mm_cmplt_epi32(c, one), _mm_cmpgt_epi32(c, lastCol)));
+        __m128i food = _mm_and_si128(
+            _mm_cmpeq_epi32(r, _mm_loadu_si128((const __m128i*)(foodRow + i))),
+            _mm_cmpeq_epi32(c, _mm_loadu_si128((const __m128i*)(foodCol + i))));
+        __m128i f = _mm_or_si128(_mm_and_si128(wall, wallBit), _mm_and_si128(food, foodBit));
+        _mm_storeu_si128((__m128i*)(flags + i), f);
+    }
+    moveScalar(i, to, actions, dir, headRow, headCol, foodRow, foodCol, rows, cols, flags);
+}
+
+__attribute__((target("avx2")))
+static void moveAvx2(int from, int to, const uint8_t* actions, int32_t* dir,
+                     int32_t* headRow, int32_t* headCol,
+                     const int32_t* foodRow, const int32_t* foodCol,
+                     int rows, int cols, int32_t* flags) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i two = _mm256_set1_epi32(2);
+    const __m256i four = _mm256_set1_epi32(ACTION_RIGHT);
+    const __m256i five = _mm256_set1_epi32(5);
+    const __m256i lastRow = _mm256_set1_epi32(rows - 2);
+    const __m256i lastCol = _mm256_set1_epi32(cols - 2);
+    const __m256i wallBit = _mm256_set1_epi32(VectorEnv::FLAG_WALL);
+    const __m256i foodBit = _mm256_set1_epi32(VectorEnv::FLAG_FOOD);
+
+    int i = from;
+    for (; i + 8 <= to; i += 8) {
+        __m256i a = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(actions + i)));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dir + i));
+
+        __m256i wanted = _mm256_sub_epi32(a, one);
+        __m256i reject = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi32(a, zero), _mm256_cmpgt_epi32(a, four)),
+            _mm256_cmpeq_epi32(wanted, _mm256_xor_si256(d, one)));
+        d = _mm256_blendv_epi8(wanted, d, reject);
+        _mm256_storeu_si256((__m256i*)(dir + i), d);
+
+        __m256i vertical = _mm256_cmpgt_epi32(two, d);
+        __m256i twiceD = _mm256_add_epi32(d, d);
+        __m256i dRow = _mm256_and_si256(vertical, _mm256_sub_epi32(twiceD, one));
+        __m256i dCol = _mm256_andnot_si256(vertical, _mm256_sub_epi32(twiceD, five));
+        __m256i r = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(headRow + i)), dRow);
+        __m256i c = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(headCol + i)), dCol);
+        _mm256_storeu_si256((__m256i*)(headRow + i), r);
+        _mm256_storeu_si256((__m256i*)(headCol + i), c);
+
+        __m256i wall = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi32(one, r), _mm256_cmpgt_epi32(r, lastRow)),
+            _mm256_or_si256(_mm256_cmpgt_epi32(one, c), _mm256_cmpgt_epi32(c, lastCol)));
+        __m256i food = _mm256_and_si256(
+            _mm256_cmpeq_epi32(r, _mm256_loadu_si256((const __m256i*)(foodRow + i))),
+            _mm256_cmpeq_epi32(c, _mm256_loadu_si256((const __m256i*)(foodCol + i))));
+        __m256i f = _mm256_or_si256(_mm256_and_si256(wall, wallBit), _mm256_and_si256(food, foodBit));
+        _mm256_storeu_si256((__m256i*)(flags + i), f);
+    }
+    moveScalar(i, to, actions, dir, headRow, headCol, foodRow, foodCol, rows, cols, flags);
+}
+#endif
+
+static bool kernelSupported(VectorEnv::Kernel kernel) {
+    switch (kernel) {
+        case VectorEnv::KERNEL_SCALAR:
+            return true;
+        #ifdef SNAKE_X86_KERNELS
+        case VectorEnv::KERNEL_SSE41:
+            return __builtin_cpu_supports("sse4.1");
+        case VectorEnv::KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2");
+        #endif
+        default:
+            return false;
+    }
+}
+
+static MoveKernel kernelFunction(VectorEnv::Kernel kernel) {
+    switch (kernel) {
+        #ifdef SNAKE_X86_KERNELS
+        case VectorEnv::KERNEL_SSE41: return moveSse41;
+        case VectorEnv::KERNEL_AVX2:  return moveAvx2;
+        #endif
+        default:                      return moveScalar;
+    }
+}
+
+VectorEnv::VectorEnv(int numBoards, int r, int c, uint64_t seed)
+    : count(numBoards), rows(r), cols(c),
+      wordsPerBoard((r * c + 63) / 64), capacity(r * c), kernel(KERNEL_SCALAR),
+      headRow(numBoards), headCol(numBoards), direction(numBoards),
+      foodRow(numBoards), foodCol(numBoards), length(numBoards), score(numBoards),
+      steps(numBoards), headSlot(numBoards), flags(numBoards), growing(numBoards),
+      done(numBoards), reward(numBoards),
+      occupancy((size_t)numBoards * ((r * c + 63) / 64)),
+      body((size_t)numBoards * r * c),
+      interiorMask((r * c + 63) / 64, 0),
+      episodes(0), episodeScoreSum(0) {
+    for (int row = 1; row < rows - 1; row++) {
+        for (int col = 1; col < cols - 1; col++) {
+            int cell = row * cols + col;
+            interiorMask[cell >> 6] |= 1ULL << (cell & 63);
+        }
+    }
+
+    rngs.reserve(count);
+    for (int i = 0; i < count; i++) {
+        rngs.push_back(Rng(splitmix64(seed + i)));
+        resetBoard(i);
+    }
+
+    setKernel(KERNEL_AVX2);
+}
+
+void VectorEnv::setKernel(Kernel wanted) {
+    while (!kernelSupported(wanted)) {
+        wanted = (Kernel)(wanted - 1);
+    }
+    kernel = wanted;
+}
+
+const char* VectorEnv::kernelName(Kernel k) {
+    switch (k) {
+        case KERNEL_AVX2:  return "avx2";
+        case KERNEL_SSE41: return "sse4.1";
+        default:           return "scalar";
+    }
+}
+
+// Same starting layout as GameBoard: length 3 at the centre heading right
+void VectorEnv::resetBoard(int i) {
+    uint64_t* bits = occupancy.data() + (size_t)i * wordsPerBoard;
+    int32_t* ring = body.data() + (size_t)i * capacity;
+    memset(bits, 0, wordsPerBoard * sizeof(uint64_t));
+
+    int row = rows / 2;
+    int col = cols / 2;
+    for (int k = 0; k < 3; k++) {
+        int cell = row * cols + col - k;
+        ring[k] = cell;
+        bits[cell >> 6] |= 1ULL << (cell & 63);
+    }
+    headRow[i] = row;
+    headCol[i] = col;
+    direction[i] = RIGHT;
+    headSlot[i] = 0;
+    length[i] = 3;
+    score[i] = 0;
+    steps[i] = 0;
+    growing[i] = 0;
+    spawnFood(i);
+}
+
+// Rejection-sample a free interior cell; on crowded boards fall back to
+// selecting the n-th free cell by popcount over the bitplane
+void VectorEnv::spawnFood(int i) {
+    const uint64_t* bits = occupancy.data() + (size_t)i * wordsPerBoard;
+    Rng& rng = rngs[i];
+
+    for (int attempt = 0; attempt < 16; attempt++) {
+        int row = 1 + rng.nextBelow(rows - 2);
+        int col = 1 + rng.nextBelow(cols - 2);
+        int cell = row * cols + col;
+        if (!((bits[cell >> 6] >> (cell & 63)) & 1)) {
+            foodRow[i] = row;
+            foodCol[i] = col;
+            return;
+        }
+    }
+
+    int freeCount = (rows - 2) * (cols - 2) - length[i];
+    if (freeCount <= 0) {
+        foodRow[i] = -1;
+        foodCol[i] = -1;
+        return;
+    }
+    int target = rng.nextBelow(freeCount);
+    for (int w = 0; w < wordsPerBoard; w++) {
+        uint64_t freeBits = ~bits[w] & interiorMask[w];
+        int n = __builtin_popcountll(freeBits);
+        if (target < n) {
+            while (target-- > 0) freeBits &= freeBits - 1;
+            int cell = w * 64 + __builtin_ctzll(freeBits);
+            foodRow[i] = cell / cols;
+            foodCol[i] = cell % cols;
+            return;
+        }
+        target -= n;
+    }
+}
+
+void VectorEnv::killBoard(int i) {
+    done[i] = 1;
+    reward[i] = -1;
+    episodes++;
+    episodeScoreSum += score[i];
+    resetBoard(i);
+}
+
+void VectorEnv::step(const uint8_t* actions) {
+    // Vector part: directions, head movement, wall and food tests
+    kernelFunction(kernel)(0, count, actions, direction.data(), headRow.data(), headCol.data(),
+                           foodRow.data(), foodCol.data(), rows, cols, flags.data());
+
+    // Scalar part: body ring, occupancy bitplane and food respawn
+    for (int i = 0; i < count; i++) {
+        done[i] = 0;
+        reward[i] = 0;
+        steps[i]++;
+
+        int32_t f = flags[i];
+        if (f & FLAG_WALL) {
+            killBoard(i);
+            continue;
+        }
+
+        uint64_t* bits = occupancy.data() + (size_t)i * wordsPerBoard;
+        int32_t* ring = body.data() + (size_t)i * capacity;
+
+        // Tail leaves before the head lands, as in GameBoard
+        if (!growing[i]) {
+            int tailSlot = headSlot[i] + length[i] - 1;
+            if (tailSlot >= capacity) tailSlot -= capacity;
+            int tail = ring[tailSlot];
+            bits[tail >> 6] &= ~(1ULL << (tail & 63));
+        } else {
+            length[i]++;
+            growing[i] = 0;
+        }
+
+        int cell = headRow[i] * cols + headCol[i];
+        uint64_t mask = 1ULL << (cell & 63);
+        if (bits[cell >> 6] & mask) {
+            killBoard(i);
+            continue;
+        }
+        bits[cell >> 6] |= mask;
+        headSlot[i] = (headSlot[i] == 0 ? capacity : headSlot[i]) - 1;
+        ring[headSlot[i]] = cell;
+
+        if (f & FLAG_FOOD) {
+            score[i] += 10;
+            reward[i] = 1;
+            growing[i] = 1;
+            spawnFood(i);
+        }
+    }
+}
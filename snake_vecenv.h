@@ -0,0 +1,93 @@
+// Lockstep "vector env": K boards of the same size advanced together.
+// State is laid out as structure-of-arrays (one contiguous array per
+// field, one occupancy bitplane per board) so movement, wall and food
+// checks for all boards run as SIMD kernels; only the per-board body
+// bookkeeping stays scalar. Dead boards reset themselves in place.
+#ifndef SNAKE_VECENV_H
+#define SNAKE_VECENV_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "snake_engine.h"
+
+class VectorEnv {
+public:
+    // Which movement kernel step() runs
+    enum Kernel {
+        KERNEL_SCALAR,
+        KERNEL_SSE41,
+        KERNEL_AVX2
+    };
+
+    // Bits of the per-board flags array written by the movement kernel
+    static const int32_t FLAG_WALL = 1;
+    static const int32_t FLAG_FOOD = 2;
+
+private:
+    int count;
+    int rows;
+    int cols;
+    int wordsPerBoard;
+    int capacity;
+    Kernel kernel;
+
+    // One entry per board
+    std::vector<int32_t> headRow;
+    std::vector<int32_t> headCol;
+    std::vector<int32_t> direction;   // Direction values, UP..RIGHT
+    std::vector<int32_t> foodRow;
+    std::vector<int32_t> foodCol;
+    std::vector<int32_t> length;
+    std::vector<int32_t> score;
+    std::vector<int32_t> steps;
+    std::vector<int32_t> headSlot;    // ring index of the head in body
+    std::vector<int32_t> flags;       // kernel output, FLAG_* bits
+    std::vector<uint8_t> growing;
+    std::vector<uint8_t> done;        // died on the last step (then reset)
+    std::vector<int8_t> reward;       // +1 food, -1 death, 0 otherwise
+    std::vector<Rng> rngs;
+
+    // Per-board blocks laid end to end
+    std::vector<uint64_t> occupancy;  // wordsPerBoard bits per board
+    std::vector<int32_t> body;        // capacity cell indices per board, ring
+    std::vector<uint64_t> interiorMask;  // shared: set bits = interior cells
+
+    // Finished episodes
+    long long episodes;
+    long long episodeScoreSum;
+
+    void resetBoard(int i);
+    void spawnFood(int i);
+    void killBoard(int i);
+
+public:
+    VectorEnv(int numBoards, int r, int c, uint64_t seed);
+
+    // Advance every board one tick. actions[i] is an Action for board i;
+    // any other value keeps the current heading, as ACTION_NONE does.
+    void step(const uint8_t* actions);
+
+    // Pick the movement kernel; falls back if the CPU lacks support
+    void setKernel(Kernel wanted);
+    Kernel getKernel() const { return kernel; }
+    static const char* kernelName(Kernel k);
+
+    int size() const { return count; }
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    const int32_t* getHeadRows() const { return headRow.data(); }
+    const int32_t* getHeadCols() const { return headCol.data(); }
+    const int32_t* getFoodRows() const { return foodRow.data(); }
+    const int32_t* getFoodCols() const { return foodCol.data(); }
+    const int32_t* getLengths() const { return length.data(); }
+    const int32_t* getScores() const { return score.data(); }
+    const uint8_t* getDones() const { return done.data(); }
+    const int8_t* getRewards() const { return reward.data(); }
+    const uint64_t* getOccupancy(int i) const { return occupancy.data() + (size_t)i * wordsPerBoard; }
+    long long getEpisodes() const { return episodes; }
+    long long getEpisodeScoreSum() const { return episodeScoreSum; }
+};
+
+#endif
@@ -0,0 +1,57 @@
+// Lock-free transposition table for search bots: a fixed power-of-two
+// array of two-word entries indexed by the low bits of a Zobrist hash.
+// Each entry keeps key ^ data beside data, so if two threads race on a
+// slot and a reader sees words from different writes, the key check fails
+// and the probe reads as a miss rather than returning another state's
+// data. Stores always overwrite. What the 64 data bits mean is up to the
+// caller; an empty slot reads as key 0 with data 0.
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class TranspositionTable {
+private:
+    struct Entry {
+        std::atomic<uint64_t> check;   // key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    std::unique_ptr<Entry[]> entries;
+    uint64_t mask;
+
+public:
+    explicit TranspositionTable(int log2Entries = 20)
+        : entries(new Entry[(size_t)1 << log2Entries]), mask(((uint64_t)1 << log2Entries) - 1) {
+        clear();
+    }
+
+    void clear() {
+        for (uint64_t i = 0; i <= mask; i++) {
+            entries[i].check.store(0, std::memory_order_relaxed);
+            entries[i].data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    bool probe(uint64_t key, uint64_t& data) const {
+        const Entry& entry = entries[key & mask];
+        uint64_t value = entry.data.load(std::memory_order_relaxed);
+        if ((entry.check.load(std::memory_order_relaxed) ^ value) != key) return false;
+        data = value;
+        return true;
+    }
+
+    void store(uint64_t key, uint64_t data) {
+        Entry& entry = entries[key & mask];
+        entry.check.store(key ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+
+    size_t size() const { return mask + 1; }
+    size_t getMemoryUsage() const { return size() * sizeof(Entry); }
+};
+
+#endif
@@ -0,0 +1,170 @@
+// Work-stealing thread pool. Each worker owns a deque: it pops its own
+// work from the back and, when that runs dry, steals from the front of
+// the other workers' deques, so uneven tasks (long and short games)
+// still keep every core busy.
+//
+// A task is a function pointer and a context pointer. The deques are
+// rings that keep their capacity, so once they have grown to the number
+// of tasks a caller keeps in flight, submitting with a context the caller
+// owns does not allocate; the MCTS planner submits that way every tick.
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+public:
+    typedef void (*TaskFunction)(void* context);
+
+private:
+    struct Task {
+        TaskFunction run;
+        void* context;
+    };
+
+    // Deque of tasks in a ring; doubles when full and never shrinks
+    struct WorkQueue {
+        std::mutex lock;
+        std::vector<Task> ring;
+        size_t first;
+        size_t count;
+
+        WorkQueue() : ring(16), first(0), count(0) {}
+
+        void pushBack(Task task) {
+            if (count == ring.size()) {
+                std::vector<Task> grown(ring.size() * 2);
+                for (size_t i = 0; i < count; i++) {
+                    grown[i] = ring[(first + i) % ring.size()];
+                }
+                ring.swap(grown);
+                first = 0;
+            }
+            ring[(first + count) % ring.size()] = task;
+            count++;
+        }
+
+        Task popBack() {
+            count--;
+            return ring[(first + count) % ring.size()];
+        }
+
+        Task popFront() {
+            Task task = ring[first];
+            first = (first + 1) % ring.size();
+            count--;
+            return task;
+        }
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<long> queued;       // tasks sitting in some deque
+    std::atomic<long> unfinished;   // tasks submitted but not yet finished
+    std::atomic<unsigned> nextQueue;
+    std::atomic<bool> stopping;
+    std::mutex sleepLock;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+
+    // Own deque first (LIFO), then steal from the others (FIFO)
+    bool takeTask(int self, Task& task) {
+        int count = queues.size();
+        for (int i = 0; i < count; i++) {
+            WorkQueue& queue = *queues[(self + i) % count];
+            std::lock_guard<std::mutex> guard(queue.lock);
+            if (queue.count == 0) continue;
+            task = i == 0 ? queue.popBack() : queue.popFront();
+            queued--;
+            return true;
+        }
+        return false;
+    }
+
+    static void runFunction(void* context) {
+        std::function<void()>* task = (std::function<void()>*)context;
+        (*task)();
+        delete task;
+    }
+
+    void workerLoop(int self) {
+        Task task;
+        while (true) {
+            if (takeTask(self, task)) {
+                task.run(task.context);
+                if (--unfinished == 0) {
+                    std::lock_guard<std::mutex> guard(sleepLock);
+                    allDone.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> guard(sleepLock);
+            workAvailable.wait(guard, [this] { return stopping || queued > 0; });
+            if (stopping && queued == 0) return;
+        }
+    }
+
+public:
+    explicit WorkStealingPool(int threadCount = 0)
+        : queued(0), unfinished(0), nextQueue(0), stopping(false) {
+        if (threadCount <= 0) {
+            threadCount = std::thread::hardware_concurrency();
+            if (threadCount <= 0) threadCount = 1;
+        }
+        for (int i = 0; i < threadCount; i++) {
+            queues.emplace_back(new WorkQueue());
+        }
+        for (int i = 0; i < threadCount; i++) {
+            threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Queue run(context); tasks are dealt round-robin and rebalanced by
+    // stealing. context must stay valid until the task has run.
+    void submit(TaskFunction run, void* context) {
+        WorkQueue& queue = *queues[nextQueue++ % queues.size()];
+        unfinished++;
+        {
+            std::lock_guard<std::mutex> guard(queue.lock);
+            Task task = { run, context };
+            queue.pushBack(task);
+            queued++;
+        }
+        std::lock_guard<std::mutex> guard(sleepLock);
+        workAvailable.notify_one();
+    }
+
+    // Queue a closure. It is moved to the heap until it has run, so this
+    // allocates per task; fine for coarse work like a chunk of games.
+    void submit(std::function<void()> task) {
+        submit(runFunction, new std::function<void()>(std::move(task)));
+    }
+
+    // Block until every submitted task has finished
+    void wait() {
+        std::unique_lock<std::mutex> guard(sleepLock);
+        allDone.wait(guard, [this] { return unfinished == 0; });
+    }
+
+    int size() const { return threads.size(); }
+};
+
+#endif